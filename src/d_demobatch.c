@@ -0,0 +1,248 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Play back a list of demos with the WADs loaded once.
+//
+//      The game starts up as usual, then a child process is forked for
+//      every demo. The children share the loaded data copy-on-write, play
+//      their demo like -timedemo and write its statistics. The parent waits
+//      for them and reports the demos that failed.
+//
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _WIN32
+#  include <sys/types.h>
+#  include <sys/wait.h>
+#  include <unistd.h>
+#endif
+
+#include "d_demobatch.h"
+#include "doomtype.h"
+#include "g_game.h"
+#include "i_exit.h"
+#include "i_printf.h"
+#include "i_system.h"
+#include "i_thread.h"
+#include "m_argv.h"
+#include "m_array.h"
+#include "m_config.h"
+#include "m_io.h"
+#include "m_misc.h"
+#include "m_parsecache.h"
+#include "r_tranmap.h"
+#include "statdump.h"
+#include "w_wad.h"
+
+#ifndef _WIN32
+
+typedef struct
+{
+    char *demo;
+    char *statdump;  // or NULL
+    char *levelstat; // or NULL
+    int pid;
+} batchdemo_t;
+
+static batchdemo_t *demos;
+
+static char *OptionalFile(const char *token)
+{
+    return (token && strcmp(token, "-")) ? M_StringDuplicate(token) : NULL;
+}
+
+// One demo per line, optionally followed by the files for its -statdump and
+// -levelstat output, "-" for none. Lines starting with '#' are skipped.
+
+static void ReadDemoList(const char *filename)
+{
+    const char *delim = " \t\r\n";
+    char line[1024];
+    FILE *file = M_fopen(filename, "r");
+
+    if (!file)
+    {
+        I_Error("Failed to open %s", filename);
+    }
+
+    while (fgets(line, sizeof(line), file))
+    {
+        char *demo = strtok(line, delim);
+
+        if (!demo || demo[0] == '#')
+        {
+            continue;
+        }
+
+        char *statdump = strtok(NULL, delim);
+        char *levelstat = statdump ? strtok(NULL, delim) : NULL;
+
+        batchdemo_t entry = {M_StringDuplicate(demo), OptionalFile(statdump),
+                             OptionalFile(levelstat), 0};
+        array_push(demos, entry);
+    }
+
+    fclose(file);
+
+    if (!array_size(demos))
+    {
+        I_Error("No demos in %s", filename);
+    }
+}
+
+static const char *StartChild(const batchdemo_t *entry)
+{
+    W_Reopen();
+
+    // The parent stays the only writer of the shared config and cache files.
+    M_DisableSaveDefaults();
+    M_DisableParseCacheWrites();
+    R_DisableTranMapCache();
+
+    if (entry->statdump)
+    {
+        StatDumpTo(entry->statdump);
+        I_AtExit(StatDump, true);
+    }
+
+    levelstat_filename = entry->levelstat;
+
+    return entry->demo;
+}
+
+static void ReportChild(int pid, int status, int *failed)
+{
+    const batchdemo_t *entry = NULL;
+
+    for (int i = 0; i < array_size(demos); ++i)
+    {
+        if (demos[i].pid == pid)
+        {
+            entry = &demos[i];
+            break;
+        }
+    }
+
+    if (!entry)
+    {
+        return;
+    }
+
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0)
+    {
+        I_Printf(VB_INFO, "D_RunDemoBatch: %s done.", entry->demo);
+    }
+    else if (WIFEXITED(status))
+    {
+        I_Printf(VB_WARNING, "D_RunDemoBatch: %s failed with exit code %d.",
+                 entry->demo, WEXITSTATUS(status));
+        (*failed)++;
+    }
+    else
+    {
+        I_Printf(VB_WARNING, "D_RunDemoBatch: %s was terminated by signal %d.",
+                 entry->demo, WIFSIGNALED(status) ? WTERMSIG(status) : 0);
+        (*failed)++;
+    }
+}
+
+#endif
+
+const char *D_RunDemoBatch(const char *filename)
+{
+#ifdef _WIN32
+    I_Error("-demolist is not supported on Windows.");
+#else
+    int jobs = 1, running = 0, failed = 0;
+    int p;
+
+    //!
+    // @arg <n>
+    // @category demo
+    //
+    // Play up to n demos of -demolist at the same time. The default is 1.
+    //
+
+    p = M_CheckParmWithArgs("-demojobs", 1);
+
+    if (p && (!M_StrToInt(myargv[p + 1], &jobs) || jobs < 1))
+    {
+        I_Error("Invalid parameter '%s' for -demojobs.", myargv[p + 1]);
+    }
+
+    if (M_CheckParm("-statdump") || M_CheckParm("-levelstat"))
+    {
+        I_Error("Give the -statdump and -levelstat files for "
+                "each demo in %s.", filename);
+    }
+
+    ReadDemoList(filename);
+
+    // Forking while other threads are alive is undefined, so the workers are
+    // joined before each fork and no jobs may be running then. Each child
+    // starts its own pool when it needs one.
+    R_WaitTranMaps();
+
+    for (int next = 0; next < array_size(demos) || running > 0;)
+    {
+        if (next < array_size(demos) && running < jobs)
+        {
+            batchdemo_t *entry = &demos[next++];
+
+            I_ShutdownWorkerThreads();
+
+            // Don't let the children write out the parent's buffered output.
+            fflush(NULL);
+
+            const pid_t pid = fork();
+
+            if (pid == 0)
+            {
+                return StartChild(entry);
+            }
+            else if (pid < 0)
+            {
+                I_Error("fork() failed: %s", strerror(errno));
+            }
+
+            entry->pid = pid;
+            running++;
+            continue;
+        }
+
+        int status;
+        pid_t pid;
+
+        while ((pid = wait(&status)) < 0 && errno == EINTR)
+        {
+        }
+
+        if (pid < 0)
+        {
+            I_Error("wait() failed: %s", strerror(errno));
+        }
+
+        running--;
+        ReportChild(pid, status, &failed);
+    }
+
+    I_Printf(VB_ALWAYS, "D_RunDemoBatch: %d of %d demos played, %d failed.",
+             array_size(demos) - failed, array_size(demos), failed);
+
+    I_SafeExit(failed ? 1 : 0);
+#endif
+}
@@ -0,0 +1,26 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Play back a list of demos with the WADs loaded once.
+//
+
+#ifndef __D_DEMOBATCH__
+#define __D_DEMOBATCH__
+
+// Called after startup, before the graphics are initialized. Returns the
+// demo to play in the child processes, the parent process exits when all
+// demos have been played.
+const char *D_RunDemoBatch(const char *filename);
+
+#endif
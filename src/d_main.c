@@ -31,6 +31,7 @@
 
 #include "am_map.h"
 #include "config.h"
+#include "d_demobatch.h"
 #include "d_demoloop.h"
 #include "d_event.h"
 #include "d_iwad.h"
@@ -68,6 +69,7 @@
 #include "mn_menu.h"
 #include "m_misc.h"
 #include "m_swap.h"
+#include "m_trace.h"
 #include "net_client.h"
 #include "net_dedicated.h"
 #include "deh_misc.h" // deh_max_health_bonus
@@ -1632,6 +1634,8 @@ void D_DoomMain(void)
 
   FindResponseFile();         // Append response file arguments to command-line
 
+  M_InitTrace();
+
   //!
   // @category net
   //
@@ -1653,6 +1657,8 @@ void D_DoomMain(void)
 
   I_Printf(VB_INFO, "W_Init: Init WADfiles.");
 
+  M_TraceBegin("IdentifyVersion");
+
   LoadBaseFile();
 
   IdentifyVersion();
@@ -1662,6 +1668,10 @@ void D_DoomMain(void)
 
   DSDH_Init();
 
+  M_TraceEnd();
+
+  M_TraceBegin("Command line");
+
   modifiedgame = false;
 
   // jff 1/24/98 set both working and command line value of play parms
@@ -2006,7 +2016,9 @@ void D_DoomMain(void)
     // Disable all sound output.
     //
 
-    int nosound = M_CheckParm("-nosound");
+    // [Woof!] the demos of -demolist are played in forked processes that
+    // can't share an audio device
+    int nosound = M_CheckParm("-nosound") || M_CheckParm("-demolist");
 
     //!
     // @vanilla
@@ -2046,19 +2058,27 @@ void D_DoomMain(void)
 
   noblit = M_CheckParm ("-noblit");
 
+  M_TraceEnd();
+
+  M_TraceBegin("M_LoadDefaults");
+
   M_InitConfig();
 
   I_PutChar(VB_INFO, '\n');
 
   M_LoadDefaults();  // load before initing other systems
 
+  M_TraceEnd();
+
   bodyquesize = default_bodyquesize; // killough 10/98
 
   // 1/18/98 killough: Z_Init call moved to i_main.c
 
   // init subsystems
 
+  M_TraceBegin("W_InitMultipleFiles");
   W_InitMultipleFiles();
+  M_TraceEnd();
 
   // Check for wolf levels
   haswolflevels = (W_CheckNumForName("map31") >= 0);
@@ -2083,6 +2103,8 @@ void D_DoomMain(void)
   //    loading DEHACKED lumps.
   //
 
+  M_TraceBegin("DEH_Load");
+
   if (gamemission == pack_chex)
   {
     DEH_LoadLumpByName("CHEXDEH");
@@ -2109,13 +2131,16 @@ void D_DoomMain(void)
 
   DEH_PostProcess();
 
+  M_TraceEnd();
+
   //
   // End DeHackEd Loading
   //
 
+  M_TraceBegin("DECL_Parse");
   W_ProcessInWads("DECLARE", DECL_Parse, PROCESS_IWAD | PROCESS_PWAD);
-
   DECL_Install();
+  M_TraceEnd();
 
   // Ambient
   P_InitAmbientSoundMobjInfo();
@@ -2155,14 +2180,18 @@ void D_DoomMain(void)
 
   if (!M_ParmExists("-nomapinfo"))
   {
-    W_ProcessInWads("UMAPINFO", G_ParseMapInfo, PROCESS_IWAD | PROCESS_PWAD);
+    M_TraceBegin("G_LoadMapInfo");
+    G_LoadMapInfo();
+    M_TraceEnd();
   }
 
   G_ParseCompDatabase();
 
   D_SetSavegameDirectory();
 
+  M_TraceBegin("V_InitColorTranslation");
   V_InitColorTranslation(); //jff 4/24/98 load color translation lumps
+  M_TraceEnd();
 
   // killough 2/22/98: copyright / "modified game" / SPA banners removed
 
@@ -2197,26 +2226,41 @@ void D_DoomMain(void)
   // Allows PWAD HELP2 screen for DOOM 1 wads (using Ultimate Doom IWAD).
   pwad_help2 = gamemode == retail && W_IsWADLump(W_CheckNumForName("HELP2"));
 
+  M_TraceBegin("S_ParseTrakInfo");
   W_ProcessInWads("TRAKINFO", S_ParseTrakInfo, PROCESS_IWAD | PROCESS_PWAD);
+  M_TraceEnd();
   D_SetupDemoLoop();
 
   I_Printf(VB_INFO, "M_Init: Init miscellaneous info.");
+  M_TraceBegin("M_Init");
   M_Init();
+  M_TraceEnd();
 
   I_Printf(VB_INFO, "R_Init: Init DOOM refresh daemon.");
+  M_TraceBegin("R_Init");
   R_Init();
+  M_TraceEnd();
 
   I_Printf(VB_INFO, "P_Init: Init Playloop state.");
+  M_TraceBegin("P_Init");
   P_Init();
+  M_TraceEnd();
 
   I_Printf(VB_INFO, "I_Init: Setting up machine state.");
+  M_TraceBegin("I_Init");
   I_SetMetadata(PROJECT_NAME, PROJECT_VERSION, PROJECT_APPID);
   I_InitTimer();
   I_InitGamepad();
+  M_TraceBegin("I_InitSound");
   I_InitSound();
+  M_TraceEnd();
+  M_TraceBegin("I_InitMusic");
   I_InitMusic();
+  M_TraceEnd();
+  M_TraceEnd();
 
   I_Printf(VB_INFO, "NET_Init: Init network subsystem.");
+  M_TraceBegin("NET_Init");
   NET_Init();
 
   // Initial netgame startup. Connect to server etc.
@@ -2224,6 +2268,7 @@ void D_DoomMain(void)
 
   I_Printf(VB_INFO, "D_CheckNetGame: Checking network game status.");
   D_CheckNetGame();
+  M_TraceEnd();
 
   G_UpdateSideMove();
   G_UpdateAngleFunctions();
@@ -2236,17 +2281,23 @@ void D_DoomMain(void)
   G_SetTimeScale();
 
   I_Printf(VB_INFO, "S_Init: Setting up sound.");
+  M_TraceBegin("S_Init");
   S_Init(snd_SfxVolume /* *8 */, snd_MusicVolume /* *8*/ );
+  M_TraceEnd();
 
   I_Printf(VB_INFO, "HU_Init: Setting up heads up display.");
 
   I_Printf(VB_INFO, "ST_Init: Init status bar.");
+  M_TraceBegin("ST_Init");
   ST_Init();
   MN_SetHUFontKerning();
+  M_TraceEnd();
 
   // andrewj: voxel support
   I_Printf(VB_INFO, "VX_Init: ");
+  M_TraceBegin("VX_Init");
   VX_Init();
+  M_TraceEnd();
 
   I_PutChar(VB_INFO, '\n');
 
@@ -2379,6 +2430,23 @@ void D_DoomMain(void)
       singledemo = true; // quit after one demo
   }
 
+  //!
+  // @arg <file>
+  // @category demo
+  //
+  // Play back each demo listed in the file like -timedemo, in processes
+  // forked after startup. A line holds a demo, optionally followed by the
+  // files for its -statdump and -levelstat output, "-" for none.
+  //
+
+  else if ((p = M_CheckParm("-demolist")) && ++p < myargc)
+  {
+      singletics = true;
+      timingdemo = true;
+      G_DeferedPlayDemo(D_RunDemoBatch(myargv[p]));
+      singledemo = true;
+  }
+
   //!
   // @arg <demo>
   // @category demo
@@ -2406,13 +2474,17 @@ void D_DoomMain(void)
   }
 
   // [FG] init graphics (video.widedelta) before HUD widgets
+  M_TraceBegin("I_InitGraphics");
   I_InitGraphics();
+  M_TraceEnd();
   I_UpdateDiscordPresence("Playing", gamedescription);
   I_InitKeyboard();
 
   MN_InitMenuStrings();
   MN_InitFreeLook();
 
+  M_TraceBegin("Game start");
+
   // Auto save slot is 255 for -loadgame command.
   if (startloadgame == 255 && !demorecording && gameaction != ga_playdemo
       && !netgame)
@@ -2451,6 +2523,10 @@ void D_DoomMain(void)
 
   TryRunTics();
 
+  M_TraceEnd();
+
+  M_FinishTrace();
+
   D_StartGameLoop();
 
   for (;;)
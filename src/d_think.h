@@ -54,6 +54,9 @@ typedef struct thinker_s
 
   struct thinker_s *cnext, *cprev; // Next, previous thinkers in same class
 
+  // [Woof!] Next, previous thinkers of the same kind, see th_kind
+  struct thinker_s *knext, *kprev;
+
   // killough 11/98: count of how many other objects reference
   // this one using pointers. Used for garbage collection.
   unsigned references;
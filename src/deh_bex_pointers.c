@@ -246,6 +246,21 @@ static void TranslateArgs(state_t *state,
     }
 }
 
+// [Woof!] Returns the mnemonic of an action pointer, or NULL if it isn't
+// one of the known codepointers.
+const char *DEH_ActionName(actionf_v action)
+{
+    for (int i = 0; bex_pointer_table[i].pointer.v != NULL; ++i)
+    {
+        if (bex_pointer_table[i].pointer.v == action)
+        {
+            return bex_pointer_table[i].mnemonic;
+        }
+    }
+
+    return NULL;
+}
+
 void DEH_ValidateStateArgs(void)
 {
     const bex_codepointer_t *bex_pointer_match;
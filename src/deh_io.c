@@ -128,7 +128,7 @@ void DEH_CloseFile(deh_context_t *context)
     }
     else if (context->type == DEH_INPUT_LUMP)
     {
-        Z_Free(lumpcache[context->lumpnum]);
+        Z_Free(context->input_buffer);
     }
 
     free(context->filename);
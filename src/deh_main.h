@@ -54,5 +54,6 @@ extern void DEH_PostProcess(void);
 extern byte DEH_GetDefinedCodepointerArgs(int frame_number);
 extern void DEH_ValidateStateArgs(void);
 extern boolean DEH_CheckSafeState(statenum_t state);
+extern const char *DEH_ActionName(actionf_v action);
 
 #endif /* #ifndef DEH_MAIN_H */
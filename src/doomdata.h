@@ -277,7 +277,7 @@ typedef struct {
   int32_t options;
   fixed_t health;
   int32_t tint;
-  byte *tranmap;
+  const byte *tranmap;
 } mapthing_t;
 
 #endif // __DOOMDATA__
@@ -80,6 +80,7 @@
 #include "p_pspr.h"
 #include "p_saveg.h"
 #include "p_setup.h"
+#include "p_statehash.h"
 #include "p_tick.h"
 #include "p_user.h"
 #include "r_data.h"
@@ -1592,7 +1593,9 @@ static void CheckDemoBuffer(size_t size)
   ptrdiff_t position = demo_p - demobuffer;
   if (position + size > maxdemosize)
   {
-    maxdemosize += size + 128 * 1024; // add another 128K
+    // [Woof!] grow geometrically, so long recordings don't reallocate
+    // (and copy) the whole buffer every 128K
+    maxdemosize = MAX(maxdemosize * 2, position + size + 128 * 1024);
     demobuffer = Z_Realloc(demobuffer, maxdemosize, PU_STATIC, 0);
     demo_p = position + demobuffer;
   }
@@ -1696,6 +1699,8 @@ static void FormatLevelStatTime(char *str, int tics, boolean total)
     }
 }
 
+const char *levelstat_filename;
+
 // [crispy] Write level statistics upon exit
 static void G_WriteLevelStat(void)
 {
@@ -1709,20 +1714,23 @@ static void G_WriteLevelStat(void)
 
     FILE *fstream = NULL;
 
+    const char *filename =
+        levelstat_filename ? levelstat_filename : "levelstat.txt";
+
     if (firsttime)
     {
         firsttime = false;
-        fstream = M_fopen("levelstat.txt", "w");
+        fstream = M_fopen(filename, "w");
     }
     else
     {
-        fstream = M_fopen("levelstat.txt", "a");
+        fstream = M_fopen(filename, "a");
     }
 
     if (fstream == NULL)
     {
         I_Printf(VB_ERROR,
-            "G_WriteLevelStat: Unable to open levelstat.txt for writing!");
+            "G_WriteLevelStat: Unable to open %s for writing!", filename);
         return;
     }
 
@@ -1768,7 +1776,7 @@ static void G_DoCompleted(void)
   // Write level statistics upon exit to levelstat.txt
   //
 
-  if (M_CheckParm("-levelstat"))
+  if (levelstat_filename || M_CheckParm("-levelstat"))
   {
       G_WriteLevelStat();
   }
@@ -2053,6 +2061,7 @@ static void G_DoPlayDemo(void)
       demolength = M_FileLength(filename);
       demo_p = demobuffer;
       I_Printf(VB_DEMO, "G_DoPlayDemo: %s", filename);
+      P_StartStateHash(filename, false);
   }
   else
   {
@@ -4670,6 +4679,8 @@ void G_BeginRecording(void)
   }
 
   displaymsg("Demo Recording: %s", M_BaseName(demoname));
+
+  P_StartStateHash(demoname, true);
 }
 
 //
@@ -4874,6 +4885,8 @@ boolean G_CheckDemoStatus(void)
         return true;
       }
 
+      P_StopStateHash();
+
       if (singledemo)
         I_SafeExit(0);  // killough
 
@@ -4896,6 +4909,8 @@ boolean G_CheckDemoStatus(void)
     {
       demorecording = false;
 
+      P_StopStateHash();
+
       if (!demo_p)
         return false;
 
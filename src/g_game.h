@@ -139,6 +139,9 @@ extern boolean secretexit;
 
 extern byte *demo_p;
 
+// [Woof!] replaces levelstat.txt, implies -levelstat
+extern const char *levelstat_filename;
+
 #endif
 
 //----------------------------------------------------------------------------
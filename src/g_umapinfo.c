@@ -24,8 +24,11 @@
 #include "dsdh_main.h"
 #include "f_finale.h"
 #include "m_array.h"
+#include "i_printf.h"
 #include "m_misc.h"
+#include "m_parsecache.h"
 #include "m_scanner.h"
+#include "memio.h"
 #include "mn_menu.h"
 #include "w_wad.h"
 #include "z_zone.h"
@@ -171,6 +174,55 @@ static const char *const actor_names[] =
     "Deh_Actor_249", // Extra thing 99
 };
 
+// [Woof!] Side effects of parsing, recorded so that they can be replayed when
+// the results are loaded from the parse cache.
+
+typedef struct
+{
+    char map[9];
+    char gfx[9];
+    char *txt;
+    char key;
+    boolean clear;
+} episode_op_t;
+
+typedef struct
+{
+    int from;
+    int to;
+} translation_t;
+
+static episode_op_t *episode_ops;
+static translation_t *translations;
+
+static void ClearEpisodes(void)
+{
+    episode_op_t op = {.clear = true};
+    array_push(episode_ops, op);
+
+    MN_ClearEpisodes();
+}
+
+static void AddEpisode(const char *map, const char *gfx, const char *txt,
+                       char key)
+{
+    episode_op_t op = {.key = key};
+    M_CopyLumpName(op.map, map);
+    M_CopyLumpName(op.gfx, gfx);
+    op.txt = txt ? M_StringDuplicate(txt) : NULL;
+    array_push(episode_ops, op);
+
+    MN_AddEpisode(map, gfx, txt, key);
+}
+
+static int TranslateThing(int type)
+{
+    translation_t translation = {type, DSDH_ThingTranslate(type)};
+    array_push(translations, translation);
+
+    return translation.to;
+}
+
 static void ReplaceString(char **to, const char *from)
 {
     if (*to != NULL)
@@ -291,7 +343,7 @@ static void ParseStandardProperty(scanner_t *s, mapentry_t *mape)
         {
             if (!strcasecmp(SC_GetString(s), "clear"))
             {
-                MN_ClearEpisodes();
+                ClearEpisodes();
             }
             else
             {
@@ -317,7 +369,7 @@ static void ParseStandardProperty(scanner_t *s, mapentry_t *mape)
                 }
             }
 
-            MN_AddEpisode(mape->mapname, lumpname, alttext, key);
+            AddEpisode(mape->mapname, lumpname, alttext, key);
 
             if (alttext)
             {
@@ -527,7 +579,7 @@ static void ParseStandardProperty(scanner_t *s, mapentry_t *mape)
                 || special == 2071 || special == 2072 || special == 2073
                 || special == 2074)
             {
-                type = DSDH_ThingTranslate(type);
+                type = TranslateThing(type);
                 bossaction_t bossaction = {type, special, tag};
                 array_push(mape->bossactions, bossaction);
             }
@@ -640,6 +692,298 @@ void G_ParseMapInfo(int lumpnum)
     SC_Close(s);
 }
 
+// [Woof!] Binary cache of the parsed UMAPINFO lumps. The results depend on the
+// game mode and on DEHACKED for thing numbers, so the raw thing numbers are
+// stored and translated again when loading.
+
+static parsecache_t *parsecache;
+static int num_lumps;
+
+static void AddLumpToCache(int lumpnum)
+{
+    M_ParseCacheAddLump(parsecache, lumpnum);
+    ++num_lumps;
+}
+
+static int UntranslateThing(int type)
+{
+    for (int i = array_size(translations) - 1; i >= 0; --i)
+    {
+        if (translations[i].to == type)
+        {
+            return translations[i].from;
+        }
+    }
+    return type;
+}
+
+#define MAPENTRY_LUMPNAMES(X) \
+    X(levelpic) X(nextmap) X(nextsecret) X(music) X(skytexture) X(endpic) \
+    X(endfinale) X(exitpic) X(enterpic) X(exitanim) X(enteranim) \
+    X(interbackdrop) X(intermusic)
+
+static void WriteMapInfo(MEMFILE *stream)
+{
+    M_CacheWriteInt(stream, array_size(translations));
+    translation_t *translation;
+    array_foreach(translation, translations)
+    {
+        M_CacheWriteInt(stream, translation->from);
+    }
+
+    M_CacheWriteInt(stream, array_size(episode_ops));
+    episode_op_t *op;
+    array_foreach(op, episode_ops)
+    {
+        M_CacheWriteInt(stream, op->clear);
+        M_CacheWriteData(stream, op->map, sizeof(op->map));
+        M_CacheWriteData(stream, op->gfx, sizeof(op->gfx));
+        M_CacheWriteString(stream, op->txt);
+        M_CacheWriteInt(stream, op->key);
+    }
+
+    M_CacheWriteInt(stream, array_size(secretlevels));
+    level_t *level;
+    array_foreach(level, secretlevels)
+    {
+        M_CacheWriteInt(stream, level->episode);
+        M_CacheWriteInt(stream, level->map);
+    }
+
+    M_CacheWriteInt(stream, array_size(umapinfo));
+    mapentry_t *entry;
+    array_foreach(entry, umapinfo)
+    {
+        M_CacheWriteString(stream, entry->mapname);
+        M_CacheWriteString(stream, entry->levelname);
+        M_CacheWriteString(stream, entry->label);
+        M_CacheWriteString(stream, entry->intertext);
+        M_CacheWriteString(stream, entry->intertextsecret);
+        M_CacheWriteString(stream, entry->author);
+#define WRITE_LUMPNAME(field) \
+        M_CacheWriteData(stream, entry->field, sizeof(entry->field));
+        MAPENTRY_LUMPNAMES(WRITE_LUMPNAME)
+#undef WRITE_LUMPNAME
+        M_CacheWriteInt(stream, entry->partime);
+        M_CacheWriteInt(stream, entry->flags);
+
+        M_CacheWriteInt(stream, array_size(entry->bossactions));
+        bossaction_t *bossaction;
+        array_foreach(bossaction, entry->bossactions)
+        {
+            M_CacheWriteInt(stream, UntranslateThing(bossaction->type));
+            M_CacheWriteInt(stream, bossaction->special);
+            M_CacheWriteInt(stream, bossaction->tag);
+        }
+    }
+}
+
+// Reads everything into temporary storage first, so that a truncated or
+// corrupt cache file doesn't leave any side effects behind.
+
+static boolean ReadMapInfo(MEMFILE *stream)
+{
+    int *things = NULL;
+    episode_op_t *ops = NULL;
+    level_t *levels = NULL;
+    mapentry_t *entries = NULL;
+    episode_op_t *op;
+    mapentry_t *entry;
+    boolean result = false;
+    int count;
+
+    if (!M_CacheReadInt(stream, &count))
+    {
+        goto end;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        int from;
+        if (!M_CacheReadInt(stream, &from))
+        {
+            goto end;
+        }
+        array_push(things, from);
+    }
+
+    if (!M_CacheReadInt(stream, &count))
+    {
+        goto end;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        episode_op_t op = {0};
+        int clear, key;
+        if (!M_CacheReadInt(stream, &clear)
+            || !M_CacheReadData(stream, op.map, sizeof(op.map))
+            || !M_CacheReadData(stream, op.gfx, sizeof(op.gfx))
+            || !M_CacheReadString(stream, &op.txt)
+            || !M_CacheReadInt(stream, &key))
+        {
+            goto end;
+        }
+        op.map[8] = op.gfx[8] = '\0';
+        op.clear = clear;
+        op.key = key;
+        array_push(ops, op);
+    }
+
+    if (!M_CacheReadInt(stream, &count))
+    {
+        goto end;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        level_t level;
+        if (!M_CacheReadInt(stream, &level.episode)
+            || !M_CacheReadInt(stream, &level.map))
+        {
+            goto end;
+        }
+        array_push(levels, level);
+    }
+
+    if (!M_CacheReadInt(stream, &count))
+    {
+        goto end;
+    }
+    for (int i = 0; i < count; ++i)
+    {
+        mapentry_t entry = {0};
+        int flags, num_bossactions;
+        boolean ok =
+            M_CacheReadString(stream, &entry.mapname)
+            && M_CacheReadString(stream, &entry.levelname)
+            && M_CacheReadString(stream, &entry.label)
+            && M_CacheReadString(stream, &entry.intertext)
+            && M_CacheReadString(stream, &entry.intertextsecret)
+            && M_CacheReadString(stream, &entry.author);
+#define READ_LUMPNAME(field)                                               \
+        ok = ok && M_CacheReadData(stream, entry.field, sizeof(entry.field)); \
+        entry.field[8] = '\0';
+        MAPENTRY_LUMPNAMES(READ_LUMPNAME)
+#undef READ_LUMPNAME
+        ok = ok && M_CacheReadInt(stream, &entry.partime)
+             && M_CacheReadInt(stream, &flags)
+             && M_CacheReadInt(stream, &num_bossactions);
+        entry.flags = flags;
+
+        for (int j = 0; ok && j < num_bossactions; ++j)
+        {
+            bossaction_t bossaction;
+            ok = M_CacheReadInt(stream, &bossaction.type)
+                 && M_CacheReadInt(stream, &bossaction.special)
+                 && M_CacheReadInt(stream, &bossaction.tag);
+            if (ok)
+            {
+                array_push(entry.bossactions, bossaction);
+            }
+        }
+
+        array_push(entries, entry);
+
+        if (!ok || !entry.mapname)
+        {
+            goto end;
+        }
+    }
+
+    // Replay the side effects in the original order.
+
+    for (int i = 0; i < array_size(things); ++i)
+    {
+        DSDH_ThingTranslate(things[i]);
+    }
+
+    array_foreach(op, ops)
+    {
+        if (op->clear)
+        {
+            MN_ClearEpisodes();
+        }
+        else
+        {
+            MN_AddEpisode(op->map, op->gfx, op->txt, op->key);
+        }
+    }
+
+    array_foreach(entry, entries)
+    {
+        bossaction_t *bossaction;
+        array_foreach(bossaction, entry->bossactions)
+        {
+            bossaction->type = DSDH_ThingTranslate(bossaction->type);
+        }
+    }
+
+    secretlevels = levels;
+    levels = NULL;
+    umapinfo = entries;
+    entries = NULL;
+    result = true;
+
+end:
+    array_free(things);
+    array_foreach(op, ops)
+    {
+        free(op->txt);
+    }
+    array_free(ops);
+    array_free(levels);
+    array_foreach(entry, entries)
+    {
+        free(entry->mapname);
+        FreeMapEntry(entry);
+    }
+    array_free(entries);
+    return result;
+}
+
+void G_LoadMapInfo(void)
+{
+    parsecache_t cache;
+    M_InitParseCache(&cache, "umapinfo");
+
+    const int depends[] = {gamemode, gamemission, pwad_help2};
+    M_ParseCacheAddData(&cache, depends, sizeof(depends));
+
+    parsecache = &cache;
+    num_lumps = 0;
+    W_ProcessInWads("UMAPINFO", AddLumpToCache, PROCESS_IWAD | PROCESS_PWAD);
+    parsecache = NULL;
+
+    if (!num_lumps)
+    {
+        M_CloseParseCache(&cache, false);
+        return;
+    }
+
+    MEMFILE *stream = M_ReadParseCache(&cache);
+    if (stream && ReadMapInfo(stream))
+    {
+        I_Printf(VB_DEBUG, "G_LoadMapInfo: loaded from parse cache");
+        M_CloseParseCache(&cache, false);
+        return;
+    }
+
+    W_ProcessInWads("UMAPINFO", G_ParseMapInfo, PROCESS_IWAD | PROCESS_PWAD);
+
+    stream = M_WriteParseCache(&cache);
+    if (stream)
+    {
+        WriteMapInfo(stream);
+    }
+    M_CloseParseCache(&cache, stream != NULL);
+
+    episode_op_t *op;
+    array_foreach(op, episode_ops)
+    {
+        free(op->txt);
+    }
+    array_free(episode_ops);
+    array_free(translations);
+}
+
 mapentry_t *G_LookupMapinfo(int episode, int map)
 {
     char lumpname[9] = {0};
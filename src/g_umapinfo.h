@@ -80,6 +80,7 @@ mapentry_t *G_LookupMapinfo(int episode, int map);
 boolean G_ValidateMapName(const char *mapname, int *episode, int *map);
 
 void G_ParseMapInfo(int lumpnum);
+void G_LoadMapInfo(void);
 
 boolean G_IsSecretMap(int episode, int map);
 
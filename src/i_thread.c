@@ -0,0 +1,336 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Worker thread pool for loading work.
+//
+//      Every worker owns a job queue, and one more queue is shared by all
+//      other threads. A thread takes the newest job from its own queue and
+//      steals the oldest job from another queue when its own is empty, so
+//      recursive work stays local and the large jobs get distributed.
+//
+
+#include <SDL3/SDL.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "i_exit.h"
+#include "i_printf.h"
+#include "i_system.h"
+#include "i_thread.h"
+#include "m_array.h"
+
+#define MAX_WORKERS 15
+
+typedef struct
+{
+    jobfunc_t func;
+    void *data;
+    jobgroup_t *group;
+} job_t;
+
+typedef struct
+{
+    SDL_Mutex *mutex;
+    job_t *jobs;
+    int head;
+} jobqueue_t;
+
+struct jobgroup_s
+{
+    SDL_AtomicInt pending;
+};
+
+static boolean initialized;
+static int num_workers;
+static SDL_Thread *workers[MAX_WORKERS];
+static jobqueue_t queues[MAX_WORKERS + 1];
+
+static SDL_AtomicInt queued;
+static SDL_AtomicInt quit;
+static SDL_Mutex *wake_mutex;
+static SDL_Condition *wake_cond;
+
+// Holds the queue number of worker threads, other threads use queue 0.
+static SDL_TLSID queue_index;
+
+static int QueueIndex(void)
+{
+    return (int)(intptr_t)SDL_GetTLS(&queue_index);
+}
+
+static void PushJob(jobqueue_t *queue, const job_t *job)
+{
+    SDL_LockMutex(queue->mutex);
+    array_push(queue->jobs, *job);
+    SDL_UnlockMutex(queue->mutex);
+}
+
+static boolean PopJob(jobqueue_t *queue, job_t *job, boolean steal)
+{
+    boolean result = false;
+
+    SDL_LockMutex(queue->mutex);
+    if (queue->head < array_size(queue->jobs))
+    {
+        if (steal)
+        {
+            *job = queue->jobs[queue->head++];
+        }
+        else
+        {
+            *job = array_pop(queue->jobs);
+        }
+
+        if (queue->head == array_size(queue->jobs))
+        {
+            array_clear(queue->jobs);
+            queue->head = 0;
+        }
+        result = true;
+    }
+    SDL_UnlockMutex(queue->mutex);
+
+    return result;
+}
+
+static boolean GetJob(int self, job_t *job)
+{
+    if (SDL_GetAtomicInt(&queued) == 0)
+    {
+        return false;
+    }
+
+    boolean result = PopJob(&queues[self], job, false);
+
+    for (int i = 1; !result && i <= num_workers; ++i)
+    {
+        result = PopJob(&queues[(self + i) % (num_workers + 1)], job, true);
+    }
+
+    if (result)
+    {
+        SDL_AddAtomicInt(&queued, -1);
+    }
+
+    return result;
+}
+
+static void RunJob(job_t *job)
+{
+    job->func(job->data);
+
+    if (SDL_AddAtomicInt(&job->group->pending, -1) == 1)
+    {
+        // Wake up threads waiting for this group.
+        SDL_LockMutex(wake_mutex);
+        SDL_BroadcastCondition(wake_cond);
+        SDL_UnlockMutex(wake_mutex);
+    }
+}
+
+static int WorkerThread(void *data)
+{
+    const int self = (int)(intptr_t)data;
+    job_t job;
+
+    SDL_SetTLS(&queue_index, data, NULL);
+
+    while (!SDL_GetAtomicInt(&quit))
+    {
+        if (GetJob(self, &job))
+        {
+            RunJob(&job);
+            continue;
+        }
+
+        SDL_LockMutex(wake_mutex);
+        while (!SDL_GetAtomicInt(&queued) && !SDL_GetAtomicInt(&quit))
+        {
+            SDL_WaitCondition(wake_cond, wake_mutex);
+        }
+        SDL_UnlockMutex(wake_mutex);
+    }
+
+    return 0;
+}
+
+void I_ShutdownWorkerThreads(void)
+{
+    if (!initialized)
+    {
+        return;
+    }
+
+    SDL_SetAtomicInt(&quit, 1);
+
+    SDL_LockMutex(wake_mutex);
+    SDL_BroadcastCondition(wake_cond);
+    SDL_UnlockMutex(wake_mutex);
+
+    for (int i = 0; i < num_workers; ++i)
+    {
+        SDL_WaitThread(workers[i], NULL);
+        workers[i] = NULL;
+    }
+    num_workers = 0;
+
+    for (int i = 0; i <= MAX_WORKERS; ++i)
+    {
+        SDL_DestroyMutex(queues[i].mutex);
+        array_free(queues[i].jobs);
+        queues[i].mutex = NULL;
+        queues[i].head = 0;
+    }
+
+    SDL_DestroyCondition(wake_cond);
+    SDL_DestroyMutex(wake_mutex);
+    wake_cond = NULL;
+    wake_mutex = NULL;
+
+    // The next job group starts a new pool.
+    SDL_SetAtomicInt(&queued, 0);
+    SDL_SetAtomicInt(&quit, 0);
+    initialized = false;
+}
+
+static void InitThreads(void)
+{
+    static boolean first = true;
+
+    if (initialized)
+    {
+        return;
+    }
+
+    initialized = true;
+
+    wake_mutex = SDL_CreateMutex();
+    wake_cond = SDL_CreateCondition();
+
+    for (int i = 0; i <= MAX_WORKERS; ++i)
+    {
+        queues[i].mutex = SDL_CreateMutex();
+    }
+
+    const int count = CLAMP(SDL_GetNumLogicalCPUCores() - 1, 0, MAX_WORKERS);
+
+    for (int i = 0; i < count; ++i)
+    {
+        workers[i] = SDL_CreateThread(WorkerThread, "worker",
+                                      (void *)(intptr_t)(i + 1));
+        if (!workers[i])
+        {
+            I_Printf(VB_WARNING, "InitThreads: %s", SDL_GetError());
+            break;
+        }
+        num_workers++;
+    }
+
+    I_Printf(VB_DEBUG, "InitThreads: %d worker threads.", num_workers);
+
+    // Run after the exit functions that may still wait for jobs.
+    if (first)
+    {
+        I_AtExitPrio(I_ShutdownWorkerThreads, false,
+                     "I_ShutdownWorkerThreads", exit_priority_last);
+        first = false;
+    }
+}
+
+int I_NumWorkerThreads(void)
+{
+    InitThreads();
+    return num_workers;
+}
+
+jobgroup_t *I_CreateJobGroup(void)
+{
+    InitThreads();
+
+    jobgroup_t *group = malloc(sizeof(*group));
+    SDL_SetAtomicInt(&group->pending, 0);
+    return group;
+}
+
+void I_AddJob(jobgroup_t *group, jobfunc_t func, void *data)
+{
+    job_t job = {func, data, group};
+
+    SDL_AddAtomicInt(&group->pending, 1);
+    PushJob(&queues[QueueIndex()], &job);
+    SDL_AddAtomicInt(&queued, 1);
+
+    SDL_LockMutex(wake_mutex);
+    SDL_SignalCondition(wake_cond);
+    SDL_UnlockMutex(wake_mutex);
+}
+
+boolean I_JobGroupDone(jobgroup_t *group)
+{
+    return SDL_GetAtomicInt(&group->pending) == 0;
+}
+
+void I_WaitJobGroup(jobgroup_t *group)
+{
+    const int self = QueueIndex();
+    job_t job;
+
+    while (SDL_GetAtomicInt(&group->pending) > 0)
+    {
+        if (GetJob(self, &job))
+        {
+            RunJob(&job);
+            continue;
+        }
+
+        // The remaining jobs are running on other threads. Wake up when one
+        // of them finishes or new jobs are queued that we can help with.
+        SDL_LockMutex(wake_mutex);
+        if (SDL_GetAtomicInt(&group->pending) > 0
+            && !SDL_GetAtomicInt(&queued))
+        {
+            SDL_WaitConditionTimeout(wake_cond, wake_mutex, 1);
+        }
+        SDL_UnlockMutex(wake_mutex);
+    }
+
+    free(group);
+}
+
+i_mutex_t *I_CreateMutex(void)
+{
+    SDL_Mutex *mutex = SDL_CreateMutex();
+
+    if (!mutex)
+    {
+        I_Error("I_CreateMutex: %s", SDL_GetError());
+    }
+
+    return (i_mutex_t *)mutex;
+}
+
+void I_DestroyMutex(i_mutex_t *mutex)
+{
+    SDL_DestroyMutex((SDL_Mutex *)mutex);
+}
+
+void I_LockMutex(i_mutex_t *mutex)
+{
+    SDL_LockMutex((SDL_Mutex *)mutex);
+}
+
+void I_UnlockMutex(i_mutex_t *mutex)
+{
+    SDL_UnlockMutex((SDL_Mutex *)mutex);
+}
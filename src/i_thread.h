@@ -0,0 +1,53 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Worker thread pool for loading work.
+//
+
+#ifndef __I_THREAD__
+#define __I_THREAD__
+
+#include "doomtype.h"
+
+typedef void (*jobfunc_t)(void *data);
+
+typedef struct jobgroup_s jobgroup_t;
+typedef struct i_mutex_s i_mutex_t;
+
+// Number of worker threads besides the main thread, may be zero.
+int I_NumWorkerThreads(void);
+
+// Joins the worker threads, e.g. before fork(), which only keeps the calling
+// thread. No jobs must be queued or running. The next job group starts a new
+// pool.
+void I_ShutdownWorkerThreads(void);
+
+jobgroup_t *I_CreateJobGroup(void);
+
+// Jobs may add further jobs, to the same group or to a new one. Jobs must not
+// call zone memory functions without holding a lock.
+void I_AddJob(jobgroup_t *group, jobfunc_t func, void *data);
+
+boolean I_JobGroupDone(jobgroup_t *group);
+
+// Runs queued jobs until all jobs of the group have finished, then frees the
+// group.
+void I_WaitJobGroup(jobgroup_t *group);
+
+i_mutex_t *I_CreateMutex(void);
+void I_DestroyMutex(i_mutex_t *mutex);
+void I_LockMutex(i_mutex_t *mutex);
+void I_UnlockMutex(i_mutex_t *mutex);
+
+#endif
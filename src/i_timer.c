@@ -49,6 +49,12 @@ int I_GetTimeMS(void)
     return ((counter - basecounter) * 1000ull) / basefreq;
 }
 
+// Monotonic time that is valid before I_InitTimer() is called.
+uint64_t I_GetTimeNS(void)
+{
+    return SDL_GetTicksNS();
+}
+
 uint64_t I_GetTimeUS(void)
 {
     uint64_t counter = SDL_GetPerformanceCounter();
@@ -483,6 +483,7 @@ static void read_mobj_t(mobj_t *str, thinker_class_t tc)
     str->friction = read32();
     str->movefactor = read32();
     str->touching_sectorlist = readp_msecnode();
+    str->secnodesafe = false; // [Woof!] see P_CreateSecNodeList()
     str->interp = read32();
     str->oldx = read32();
     str->oldy = read32();
@@ -1426,6 +1427,8 @@ static void UnArchiveWorld(void)
             }
         }
     }
+
+    P_InvalidateSightCache(); // [Woof!] heights were restored
 }
 
 //
@@ -2053,6 +2056,8 @@ void P_UnArchiveKeyframe(void)
 {
     StartUnArchive();
 
+    P_InvalidateCorpseIndex();
+
     PrepareUnArchiveThinkers();
     read_thinker_t(&thinkercap, tc_none);
     for (int i = 0; i < NUMTHCLASS; ++i)
@@ -2103,6 +2108,7 @@ void P_UnArchiveKeyframe(void)
     UnArchivePlayers();
 
     UnArchiveThinkers();
+    P_RebuildThinkerKinds();
 
     UnArchiveMSecNodes();
 
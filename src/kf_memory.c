@@ -313,6 +313,8 @@ static void UnArchiveWorld(void)
         side->textureoffset = read32();
         side->rowoffset = read32();
     }
+
+    P_InvalidateSightCache(); // [Woof!] heights were restored
 }
 
 static void ArchivePlayState(keyframe_t *keyframe)
@@ -481,10 +483,14 @@ void P_LoadKeyframe(const keyframe_t *keyframe)
     playback_tic = read32();
     playback_totaltics = read32();
 
+    P_InvalidateCorpseIndex();
+
     P_MapStart();
     UnArchivePlayers();
     UnArchiveWorld();
     UnArchivePlayState(keyframe);
+    P_RebuildThinkerKinds();
+    P_ResetSecNodeBoxes();
     UnArchiveRNG();
     UnArchiveAutomap();
     P_MapEnd();
@@ -781,12 +781,12 @@ static void cheat_massacre(void)    // jff 2/01/98 kill all monsters
   // fixed lost soul bug (LSs left behind when PEs are killed)
 
   int killcount=0;
-  thinker_t *currentthinker=&thinkercap;
+  thinker_t *currentthinker=&thinkerkindcap[tk_mobj];
   // killough 7/20/98: kill friendly monsters only if no others to kill
   int mask = MF_FRIEND;
   P_MapStart();
   do
-    while ((currentthinker=currentthinker->next)!=&thinkercap)
+    while ((currentthinker=currentthinker->knext)!=&thinkerkindcap[tk_mobj])
       if (currentthinker->function.p1 == P_MobjThinker &&
 	  !(((mobj_t *) currentthinker)->flags & mask) && // killough 7/20/98
 	  (((mobj_t *) currentthinker)->flags & MF_COUNTKILL ||
@@ -897,7 +897,8 @@ static void cheat_spechits(void)
   {
     thinker_t *th;
 
-    for (th = thinkercap.next ; th != &thinkercap ; th = th->next)
+    for (th = thinkerkindcap[tk_mobj].knext ; th != &thinkerkindcap[tk_mobj] ;
+         th = th->knext)
     {
       if (th->function.p1 == P_MobjThinker)
       {
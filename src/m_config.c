@@ -206,6 +206,17 @@ default_t *M_LookupDefault(const char *name)
     return dp;
 }
 
+//
+// M_DisableSaveDefaults
+//
+// [Woof!] For processes that must leave the config file to another one.
+//
+
+void M_DisableSaveDefaults(void)
+{
+    defaults_loaded = false;
+}
+
 //
 // M_SaveDefaults
 //
@@ -18,6 +18,7 @@
 #include <SDL3/SDL.h>
 
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -27,15 +28,19 @@
 #  include <io.h>
 #  include <windows.h>
 #else
-#  include <fcntl.h>
+#  include <sys/mman.h>
 #  include <unistd.h>
 #endif
 
+#include <sys/stat.h>
 #include <sys/types.h>
 
+#include "config.h"
+#include "doomtype.h"
 #include "i_printf.h"
 #include "i_system.h"
 #include "m_array.h"
+#include "m_io.h"
 #include "m_misc.h"
 
 #ifdef _WIN32
@@ -153,6 +158,157 @@ FILE *M_fopen(const char *filename, const char *mode)
 #endif
 }
 
+// Unbuffered file descriptors for positional reads. M_pread() neither uses
+// nor moves a shared file position, so several threads can read from the
+// same descriptor at once.
+
+int M_open(const char *filename)
+{
+#ifdef _WIN32
+    wchar_t *wname = ConvertUtf8ToWide(filename);
+
+    if (!wname)
+    {
+        return -1;
+    }
+
+    int fd = _wopen(wname, _O_RDONLY | _O_BINARY);
+
+    free(wname);
+
+    return fd;
+#else
+    return open(filename, O_RDONLY);
+#endif
+}
+
+int M_close(int fd)
+{
+#ifdef _WIN32
+    return _close(fd);
+#else
+    return close(fd);
+#endif
+}
+
+int64_t M_filesize(int fd)
+{
+#ifdef _WIN32
+    return _filelengthi64(fd);
+#else
+    struct stat st;
+
+    if (fstat(fd, &st) < 0)
+    {
+        return -1;
+    }
+
+    return st.st_size;
+#endif
+}
+
+int64_t M_pread(int fd, void *buffer, size_t count, int64_t offset)
+{
+    char *dest = buffer;
+    size_t total = 0;
+
+    while (total < count)
+    {
+#ifdef _WIN32
+        HANDLE handle = (HANDLE)_get_osfhandle(fd);
+        OVERLAPPED overlapped = {0};
+        DWORD chunk = (DWORD)MIN(count - total, 0x40000000);
+        DWORD result = 0;
+
+        overlapped.Offset = (DWORD)(offset & 0xFFFFFFFF);
+        overlapped.OffsetHigh = (DWORD)(offset >> 32);
+
+        if (!ReadFile(handle, dest + total, chunk, &result, &overlapped))
+        {
+            if (GetLastError() == ERROR_HANDLE_EOF)
+            {
+                break;
+            }
+            errno = EIO;
+            return -1;
+        }
+#else
+        ssize_t result = pread(fd, dest + total, count - total, offset);
+
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+#endif
+        if (result == 0)
+        {
+            break;
+        }
+
+        total += result;
+        offset += result;
+    }
+
+    return total;
+}
+
+void M_fadvise(int fd, int64_t offset, int64_t length, fadvise_t advice)
+{
+#ifdef HAVE_POSIX_FADVISE
+    static const int advices[] = {
+        [FADVISE_SEQUENTIAL] = POSIX_FADV_SEQUENTIAL,
+        [FADVISE_RANDOM] = POSIX_FADV_RANDOM,
+        [FADVISE_WILLNEED] = POSIX_FADV_WILLNEED,
+    };
+
+    posix_fadvise(fd, offset, length, advices[advice]);
+#else
+    (void)fd;
+    (void)offset;
+    (void)length;
+    (void)advice;
+#endif
+}
+
+void *M_mmap(int fd, int64_t length)
+{
+#ifdef _WIN32
+    HANDLE handle = (HANDLE)_get_osfhandle(fd);
+    HANDLE mapping = CreateFileMappingW(handle, NULL, PAGE_READONLY, 0, 0,
+                                        NULL);
+
+    if (!mapping)
+    {
+        return NULL;
+    }
+
+    void *ptr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, (SIZE_T)length);
+
+    // The view keeps the mapping alive.
+    CloseHandle(mapping);
+
+    return ptr;
+#else
+    void *ptr = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    return ptr == MAP_FAILED ? NULL : ptr;
+#endif
+}
+
+void M_munmap(void *ptr, int64_t length)
+{
+#ifdef _WIN32
+    (void)length;
+    UnmapViewOfFile(ptr);
+#else
+    munmap(ptr, length);
+#endif
+}
+
 int M_remove(const char *path)
 {
     return SDL_RemovePath(path) ? 0 : -1;
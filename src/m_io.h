@@ -18,9 +18,28 @@
 #ifndef M_IO_INCLUDED
 #define M_IO_INCLUDED
 
+#include <stdint.h>
 #include <stdio.h>
 
 FILE *M_fopen(const char *filename, const char *mode);
+
+typedef enum
+{
+    FADVISE_SEQUENTIAL,
+    FADVISE_RANDOM,
+    FADVISE_WILLNEED
+} fadvise_t;
+
+int M_open(const char *filename);
+int M_close(int fd);
+int64_t M_filesize(int fd);
+int64_t M_pread(int fd, void *buffer, size_t count, int64_t offset);
+void M_fadvise(int fd, int64_t offset, int64_t length, fadvise_t advice);
+
+// Maps a whole file read-only into memory, returns NULL on failure. The
+// mapping stays valid after the file is closed.
+void *M_mmap(int fd, int64_t length);
+void M_munmap(void *ptr, int64_t length);
 int M_remove(const char *path);
 int M_rename(const char *oldname, const char *newname);
 void M_MakeDirectory(const char *dir);
@@ -654,25 +654,28 @@ boolean M_WriteFile(char const *name, const void *source, int length)
 // M_ReadFile
 //
 // killough 9/98: rewritten to use stdio and to flash disk icon
+// [Woof!] read the whole file with positional reads
 
 int M_ReadFile(char const *name, byte **buffer)
 {
-    FILE *fp;
+    int fd = M_open(name);
 
-    if ((fp = M_fopen(name, "rb")))
+    if (fd >= 0)
     {
-        size_t length;
+        int64_t length = M_filesize(fd);
 
-        fseek(fp, 0, SEEK_END);
-        length = ftell(fp);
-        fseek(fp, 0, SEEK_SET);
-        *buffer = Z_Malloc(length, PU_STATIC, 0);
-        if (fread(*buffer, 1, length, fp) == length)
+        if (length >= 0)
         {
-            fclose(fp);
-            return length;
+            M_fadvise(fd, 0, length, FADVISE_SEQUENTIAL);
+
+            *buffer = Z_Malloc(length, PU_STATIC, 0);
+            if (M_pread(fd, *buffer, length, 0) == length)
+            {
+                M_close(fd);
+                return length;
+            }
         }
-        fclose(fp);
+        M_close(fd);
     }
 
     I_Error("Couldn't read file %s", name);
@@ -0,0 +1,261 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "config.h"
+#include "d_iwad.h"
+#include "i_printf.h"
+#include "m_argv.h"
+#include "m_io.h"
+#include "m_misc.h"
+#include "m_parsecache.h"
+#include "m_swap.h"
+#include "w_wad.h"
+#include "z_zone.h"
+
+static const char cache_magic[8] = "WOOFPC1";
+
+// Sanity limit for strings read from corrupted cache files.
+#define MAX_STRING_LENGTH (16 * 1024 * 1024)
+
+static boolean read_only;
+
+static boolean CacheEnabled(void)
+{
+    //!
+    // @category mod
+    //
+    // Don't read or write the binary caches of parsed UMAPINFO lumps, of
+    // nodes built by NanoBSP and of built blockmaps. Useful while editing
+    // them.
+    //
+
+    return !M_ParmExists("-noparsecache");
+}
+
+void M_InitParseCache(parsecache_t *cache, const char *name)
+{
+    memset(cache, 0, sizeof(*cache));
+    cache->name = name;
+
+    MD5Init(&cache->md5);
+    MD5Update(&cache->md5, (const md5byte *)PROJECT_STRING,
+              strlen(PROJECT_STRING));
+    MD5Update(&cache->md5, (const md5byte *)name, strlen(name));
+}
+
+void M_ParseCacheAddData(parsecache_t *cache, const void *data, int size)
+{
+    MD5Update(&cache->md5, data, size);
+}
+
+void M_ParseCacheAddLump(parsecache_t *cache, int lumpnum)
+{
+    int size = W_LumpLength(lumpnum);
+
+    M_ParseCacheAddData(cache, &size, sizeof(size));
+    M_ParseCacheAddData(cache, W_CacheLumpNum(lumpnum, PU_CACHE), size);
+}
+
+static void MakeFilename(parsecache_t *cache)
+{
+    byte digest[16];
+    char digest_string[33];
+
+    MD5Final(digest, &cache->md5);
+    M_DigestToString(digest, digest_string, sizeof(digest));
+
+    char *dir = M_StringJoin(D_DoomPrefDir(), DIR_SEPARATOR_S, "parsecache");
+    M_MakeDirectory(dir);
+
+    cache->filename = M_StringJoin(dir, DIR_SEPARATOR_S, cache->name, "_",
+                                   digest_string, ".bin");
+    free(dir);
+}
+
+MEMFILE *M_ReadParseCache(parsecache_t *cache)
+{
+    if (!CacheEnabled())
+    {
+        return NULL;
+    }
+
+    if (!cache->filename)
+    {
+        MakeFilename(cache);
+    }
+
+    // A missing or unreadable cache file is not an error, the lumps are
+    // parsed instead.
+    const int fd = M_open(cache->filename);
+
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    const int64_t length = M_filesize(fd);
+
+    if (length < (int64_t)sizeof(cache_magic) || length > INT_MAX)
+    {
+        M_close(fd);
+        return NULL;
+    }
+
+    cache->buffer = Z_Malloc(length, PU_STATIC, NULL);
+
+    if (M_pread(fd, cache->buffer, length, 0) != length
+        || memcmp(cache->buffer, cache_magic, sizeof(cache_magic)))
+    {
+        M_close(fd);
+        Z_Free(cache->buffer);
+        cache->buffer = NULL;
+        return NULL;
+    }
+
+    M_close(fd);
+
+    cache->stream = mem_fopen_read(cache->buffer + sizeof(cache_magic),
+                                   length - sizeof(cache_magic));
+    return cache->stream;
+}
+
+MEMFILE *M_WriteParseCache(parsecache_t *cache)
+{
+    if (read_only || !CacheEnabled())
+    {
+        return NULL;
+    }
+
+    if (!cache->filename)
+    {
+        MakeFilename(cache);
+    }
+
+    if (cache->stream)
+    {
+        mem_fclose(cache->stream);
+    }
+
+    cache->stream = mem_fopen_write();
+    mem_fwrite(cache_magic, 1, sizeof(cache_magic), cache->stream);
+    return cache->stream;
+}
+
+void M_CloseParseCache(parsecache_t *cache, boolean save)
+{
+    if (cache->stream)
+    {
+        if (save && !read_only)
+        {
+            void *data;
+            size_t size;
+
+            mem_get_buf(cache->stream, &data, &size);
+            if (M_WriteFile(cache->filename, data, size))
+            {
+                I_Printf(VB_DEBUG, "M_CloseParseCache: wrote %s",
+                         cache->filename);
+            }
+        }
+        mem_fclose(cache->stream);
+    }
+
+    if (cache->buffer)
+    {
+        Z_Free(cache->buffer);
+    }
+
+    free(cache->filename);
+    memset(cache, 0, sizeof(*cache));
+}
+
+void M_DisableParseCacheWrites(void)
+{
+    read_only = true;
+}
+
+void M_CacheWriteInt(MEMFILE *stream, int value)
+{
+    value = LONG(value);
+    mem_fwrite(&value, sizeof(value), 1, stream);
+}
+
+void M_CacheWriteString(MEMFILE *stream, const char *string)
+{
+    if (!string)
+    {
+        M_CacheWriteInt(stream, -1);
+        return;
+    }
+
+    int length = strlen(string);
+    M_CacheWriteInt(stream, length);
+    mem_fwrite(string, 1, length, stream);
+}
+
+void M_CacheWriteData(MEMFILE *stream, const void *data, int size)
+{
+    mem_fwrite(data, 1, size, stream);
+}
+
+boolean M_CacheReadInt(MEMFILE *stream, int *value)
+{
+    if (mem_fread(value, sizeof(*value), 1, stream) != 1)
+    {
+        return false;
+    }
+
+    *value = LONG(*value);
+    return true;
+}
+
+boolean M_CacheReadString(MEMFILE *stream, char **string)
+{
+    int length;
+
+    if (!M_CacheReadInt(stream, &length))
+    {
+        return false;
+    }
+
+    if (length < 0)
+    {
+        *string = NULL;
+        return true;
+    }
+
+    if (length > MAX_STRING_LENGTH)
+    {
+        return false;
+    }
+
+    *string = malloc(length + 1);
+    if (mem_fread(*string, 1, length, stream) != length)
+    {
+        free(*string);
+        *string = NULL;
+        return false;
+    }
+    (*string)[length] = '\0';
+    return true;
+}
+
+boolean M_CacheReadData(MEMFILE *stream, void *data, int size)
+{
+    return mem_fread(data, 1, size, stream) == size;
+}
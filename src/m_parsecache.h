@@ -0,0 +1,63 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Binary cache for the results of parsing text lumps. Cache files are keyed by
+// an MD5 digest of the engine version, the cache name, the source lumps and
+// anything else the results depend on.
+//
+// Only parsers whose results are a self-contained data structure can use it,
+// so far UMAPINFO. DEHACKED and BEX patch the global state, mobj, weapon,
+// sound and string tables in place, and later patches build on earlier ones,
+// so they are always parsed.
+
+#ifndef M_PARSECACHE_H
+#define M_PARSECACHE_H
+
+#include "doomtype.h"
+#include "md5.h"
+#include "memio.h"
+
+typedef struct
+{
+    struct MD5Context md5;
+    const char *name;
+    char *filename;
+    byte *buffer;
+    MEMFILE *stream;
+} parsecache_t;
+
+void M_InitParseCache(parsecache_t *cache, const char *name);
+void M_ParseCacheAddData(parsecache_t *cache, const void *data, int size);
+void M_ParseCacheAddLump(parsecache_t *cache, int lumpnum);
+
+// Returns a stream to read the cached results from, or NULL if there are none.
+MEMFILE *M_ReadParseCache(parsecache_t *cache);
+
+// Returns a stream to write the results to, or NULL if caching is disabled.
+MEMFILE *M_WriteParseCache(parsecache_t *cache);
+
+// Writes the results to disk if `save` is set and frees everything.
+void M_CloseParseCache(parsecache_t *cache, boolean save);
+
+// Keeps reading the caches but never writes them again.
+void M_DisableParseCacheWrites(void);
+
+void M_CacheWriteInt(MEMFILE *stream, int value);
+void M_CacheWriteString(MEMFILE *stream, const char *string);
+void M_CacheWriteData(MEMFILE *stream, const void *data, int size);
+
+boolean M_CacheReadInt(MEMFILE *stream, int *value);
+boolean M_CacheReadString(MEMFILE *stream, char **string);
+boolean M_CacheReadData(MEMFILE *stream, void *data, int size);
+
+#endif
@@ -0,0 +1,187 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "m_trace.h"
+
+#include "doomtype.h"
+#include "i_printf.h"
+#include "i_timer.h"
+#include "m_argv.h"
+#include "m_array.h"
+#include "m_io.h"
+
+#define MAX_DEPTH 16
+
+typedef struct
+{
+    const char *name;
+    uint64_t start; // ns since M_InitTrace()
+    uint64_t duration;
+    clock_t cpu_start;
+    clock_t cpu;
+    int depth;
+} trace_event_t;
+
+boolean trace_enabled;
+
+static const char *trace_filename;
+static uint64_t trace_start;
+static clock_t trace_cpu_start;
+
+static trace_event_t *trace_events;
+static int stack[MAX_DEPTH];
+static int depth;
+
+void M_InitTrace(void)
+{
+    //!
+    // @category obscure
+    // @arg <file>
+    //
+    // Record the time spent in each startup stage, write it to the given
+    // file in Chrome trace-event format and print a summary.
+    //
+
+    int p = M_CheckParmWithArgs("-startuptrace", 1);
+
+    if (!p)
+    {
+        return;
+    }
+
+    trace_filename = myargv[p + 1];
+    trace_start = I_GetTimeNS();
+    trace_cpu_start = clock();
+    trace_enabled = true;
+}
+
+void M_TraceBegin(const char *name)
+{
+    if (!trace_enabled)
+    {
+        return;
+    }
+
+    if (depth == MAX_DEPTH)
+    {
+        I_Printf(VB_WARNING, "M_TraceBegin: %s nested too deeply.", name);
+        return;
+    }
+
+    trace_event_t event = {
+        .name = name,
+        .start = I_GetTimeNS() - trace_start,
+        .cpu_start = clock(),
+        .depth = depth
+    };
+
+    stack[depth++] = array_size(trace_events);
+    array_push(trace_events, event);
+}
+
+void M_TraceEnd(void)
+{
+    if (!trace_enabled || depth == 0)
+    {
+        return;
+    }
+
+    trace_event_t *event = &trace_events[stack[--depth]];
+
+    event->duration = I_GetTimeNS() - trace_start - event->start;
+    event->cpu = clock() - event->cpu_start;
+}
+
+static double ToMS(clock_t cpu)
+{
+    return cpu * 1000.0 / CLOCKS_PER_SEC;
+}
+
+static void WriteTrace(void)
+{
+    FILE *file = M_fopen(trace_filename, "w");
+
+    if (!file)
+    {
+        I_Printf(VB_WARNING, "M_FinishTrace: Failed to open %s",
+                 trace_filename);
+        return;
+    }
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (int i = 0; i < array_size(trace_events); ++i)
+    {
+        const trace_event_t *event = &trace_events[i];
+
+        fprintf(file,
+                "%s{\"name\":\"%s\",\"cat\":\"startup\",\"ph\":\"X\","
+                "\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f,"
+                "\"args\":{\"cpu_ms\":%.3f}}",
+                i ? ",\n" : "", event->name, event->start / 1000.0,
+                event->duration / 1000.0, ToMS(event->cpu));
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    I_Printf(VB_ALWAYS, "Startup trace written to %s", trace_filename);
+}
+
+static void PrintSummary(void)
+{
+    const uint64_t total = I_GetTimeNS() - trace_start;
+    const clock_t total_cpu = clock() - trace_cpu_start;
+
+    I_Printf(VB_ALWAYS, "%-36s %10s %10s %6s", "Stage", "Wall (ms)",
+             "CPU (ms)", "%");
+
+    for (int i = 0; i < array_size(trace_events); ++i)
+    {
+        const trace_event_t *event = &trace_events[i];
+        char name[37];
+
+        snprintf(name, sizeof(name), "%*s%s", event->depth * 2, "",
+                 event->name);
+
+        I_Printf(VB_ALWAYS, "%-36s %10.2f %10.2f %6.1f", name,
+                 event->duration / 1000000.0, ToMS(event->cpu),
+                 total ? 100.0 * event->duration / total : 0.0);
+    }
+
+    I_Printf(VB_ALWAYS, "%-36s %10.2f %10.2f %6.1f", "Total",
+             total / 1000000.0, ToMS(total_cpu), 100.0);
+}
+
+void M_FinishTrace(void)
+{
+    if (!trace_enabled)
+    {
+        return;
+    }
+
+    while (depth > 0)
+    {
+        M_TraceEnd();
+    }
+
+    WriteTrace();
+    PrintSummary();
+
+    array_free(trace_events);
+    trace_enabled = false;
+}
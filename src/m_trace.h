@@ -0,0 +1,34 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// Startup tracer. Records wall-clock and CPU time of nested stages and writes
+// them as a Chrome trace-event JSON file (chrome://tracing, Perfetto).
+
+#ifndef M_TRACE_H
+#define M_TRACE_H
+
+#include "doomtype.h"
+
+extern boolean trace_enabled;
+
+void M_InitTrace(void);
+
+// Stages must be closed in reverse order of opening. The name must be a
+// string literal or otherwise outlive the trace.
+void M_TraceBegin(const char *name);
+void M_TraceEnd(void);
+
+// Closes any open stages, writes the trace file and prints a summary.
+void M_FinishTrace(void);
+
+#endif
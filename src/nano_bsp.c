@@ -29,9 +29,15 @@
 
 #include "doomdata.h"
 #include "doomtype.h"
+#include "i_printf.h"
+#include "i_system.h"
+#include "i_thread.h"
 #include "m_arena.h"
+#include "m_array.h"
 #include "m_bbox.h"
 #include "m_fixed.h"
+#include "m_hashmap.h"
+#include "m_parsecache.h"
 #include "p_bsp.h"
 #include "r_defs.h"
 #include "r_main.h"
@@ -50,6 +56,20 @@
 // (I am not sure exactly why).  higher values are okay.
 #define SPLIT_COST  11
 
+// [Woof!] subtrees with at least this many segs on both sides of the
+// partition are built in parallel.
+#define PARALLEL_THRESHOLD  256
+
+// [Woof!] soups with at least this many segs have the slow partition
+// search spread over the worker threads.
+#define PARALLEL_EVAL_THRESHOLD  2048
+
+// [Woof!] bump when the node builder or the cache file format changes.
+#define NODE_CACHE_VERSION  2
+
+// [Woof!] ints per node in the cache file.
+#define NODE_CACHE_FIELDS  14
+
 
 #undef MAX
 #define MAX(a, b)  ((a) > (b) ? (a) : (b))
@@ -77,9 +97,19 @@ struct Nanode
 };
 
 
+// [Woof!] the zone allocator is not thread-safe, so new vertices are
+// allocated under a lock and recorded for the node cache.  Segs and
+// nodes are temporary and come from the C heap instead.
+static i_mutex_t * vertex_mutex;
+static vertex_t ** nano_vertices;
+
 vertex_t * BSP_NewVertex (fixed_t x, fixed_t y)
 {
+	I_LockMutex (vertex_mutex);
 	vertex_t * vert = Z_Malloc(sizeof(vertex_t), PU_LEVEL, NULL);
+	array_push (nano_vertices, vert);
+	I_UnlockMutex (vertex_mutex);
+
 	vert->x = x;
 	vert->y = y;
 	vert->r_x = x; // [FG] Woof!'ism
@@ -89,14 +119,14 @@ vertex_t * BSP_NewVertex (fixed_t x, fixed_t y)
 
 seg_t * BSP_NewSeg (void)
 {
-	seg_t * seg = Z_Malloc (sizeof(seg_t), PU_LEVEL, NULL);
+	seg_t * seg = I_Realloc (NULL, sizeof(seg_t));
 	memset (seg, 0, sizeof(*seg));
 	return seg;
 }
 
 nanode_t * BSP_NewNode (void)
 {
-	nanode_t * node = Z_Malloc (sizeof(nanode_t), PU_LEVEL, NULL);
+	nanode_t * node = I_Realloc (NULL, sizeof(nanode_t));
 	memset (node, 0, sizeof(*node));
 	return node;
 }
@@ -385,15 +415,9 @@ boolean BSP_EvalPartition (seg_t * part, seg_t * soup, struct NodeEval * eval)
 // Look for an axis-aligned seg which can divide the other segs
 // in a "nice" way.  returns NULL if none found.
 //
-seg_t * BSP_PickNode_Fast (seg_t * soup)
+seg_t * BSP_PickNode_Fast (seg_t * soup, int count)
 {
 	// use slower method when number of segs is below a threshold
-	int count = 0;
-
-	seg_t * S;
-	for (S = soup ; S != NULL ; S = S->next)
-		count += 1;
-
 	if (count < FAST_THRESHOLD)
 		return NULL;
 
@@ -458,33 +482,224 @@ seg_t * BSP_PickNode_Fast (seg_t * soup)
 	return NULL;
 }
 
+//
+// [Woof!] the seg coordinates of a soup packed into arrays, so that
+// the slow partition search runs over contiguous memory instead of
+// chasing seg and vertex pointers.
+//
+typedef struct
+{
+	int count;
+	seg_t ** segs;
+	fixed_t * x1, * y1, * x2, * y2;
+} nanosoup_t;
+
+void BSP_PackSoup (seg_t * soup, int count, nanosoup_t * packed)
+{
+	packed->count = count;
+	packed->segs  = I_Realloc (NULL, count * (sizeof(seg_t *) + 4 * sizeof(fixed_t)));
+	packed->x1    = (fixed_t *) (packed->segs + count);
+	packed->y1    = packed->x1 + count;
+	packed->x2    = packed->y1 + count;
+	packed->y2    = packed->x2 + count;
+
+	int i;
+	seg_t * S;
+	for (S = soup, i = 0 ; S != NULL ; S = S->next, i++)
+	{
+		packed->segs[i] = S;
+		packed->x1[i] = S->v1->x;
+		packed->y1[i] = S->v1->y;
+		packed->x2[i] = S->v2->x;
+		packed->y2[i] = S->v2->y;
+	}
+}
+
+static inline int BSP_SignEpsilon (fixed_t dist)
+{
+	return (dist < - DIST_EPSILON) ? -1 : (dist > + DIST_EPSILON) ? +1 : 0;
+}
+
+//
+// Same as BSP_EvalPartition() for the seg at index `p`, but returns
+// the cost directly.  returns INT_MAX when the partition is not viable
+// or when its cost cannot get below `best_cost`.
+//
+int BSP_EvalPartition_Packed (const nanosoup_t * soup, int p, int best_cost)
+{
+	fixed_t px = soup->x1[p];
+	fixed_t py = soup->y1[p];
+	fixed_t dx = soup->x2[p] - px;
+	fixed_t dy = soup->y2[p] - py;
+
+	// do not create tiny partitions
+	if (abs (dx) < 4*DIST_EPSILON && abs (dy) < 4*DIST_EPSILON)
+		return INT_MAX;
+
+	// this is BSP_PointOnSide() with the loop-invariant parts hoisted
+	// out: the distance is measured along the minor axis `b`, and the
+	// slope is zero for axis-aligned partitions.
+	const fixed_t * a1, * b1, * a2, * b2;
+	fixed_t pa, pb, slope;
+	int flip;
+
+	if (abs (dx) >= abs (dy))
+	{
+		a1 = soup->x1; b1 = soup->y1; a2 = soup->x2; b2 = soup->y2;
+		pa = px; pb = py;
+		slope = FixedDiv (dy, dx);
+		flip = (dx > 0) ? -1 : +1;
+	}
+	else
+	{
+		a1 = soup->y1; b1 = soup->x1; a2 = soup->y2; b2 = soup->x2;
+		pa = py; pb = px;
+		slope = FixedDiv (dx, dy);
+		flip = (dy > 0) ? +1 : -1;
+	}
+
+	int left = 0, right = 0, split = 0;
+	int count = soup->count;
+
+	int i;
+	for (i = 0 ; i < count ; i++)
+	{
+		int side1 = flip * BSP_SignEpsilon ((b1[i] - pb) - FixedMul (a1[i] - pa, slope));
+		int side2 = flip * BSP_SignEpsilon ((b2[i] - pb) - FixedMul (a2[i] - pa, slope));
+
+		if (i == p)
+		{
+			right += 1;
+		}
+		else if (side1 == 0 && side2 == 0)
+		{
+			// colinear, see BSP_SameDirection()
+			int64_t n = (int64_t)(soup->x2[i] - soup->x1[i]) * (int64_t)dx +
+			            (int64_t)(soup->y2[i] - soup->y1[i]) * (int64_t)dy;
+
+			if (n > 0)
+				right += 1;
+			else
+				left += 1;
+		}
+		else if ((side1 * side2) < 0)
+			split += 1;
+		else if (side1 >= 0 && side2 >= 0)
+			right += 1;
+		else
+			left += 1;
+
+		// give up once the remaining segs cannot make this cheaper
+		// than the best partition so far.
+		if ((i & 15) == 15)
+		{
+			int imbalance = abs (left - right) - (count - 1 - i);
+
+			if (split * SPLIT_COST + MAX (imbalance, 0) * 2 >= best_cost)
+				return INT_MAX;
+		}
+	}
+
+	// a viable partition either splits something, or has other segs
+	// lying on *both* the left and right sides.
+
+	if (split == 0 && (left == 0 || right == 0))
+		return INT_MAX;
+
+	return abs (left - right) * 2 + split * SPLIT_COST;
+}
+
+typedef struct
+{
+	const nanosoup_t * soup;
+	int start, end;
+	int best, best_cost;
+} picknode_job_t;
+
+void BSP_PickNode_Range (picknode_job_t * job)
+{
+	job->best = -1;
+	job->best_cost = (1 << 30);
+
+	int p;
+	for (p = job->start ; p < job->end ; p++)
+	{
+		int cost = BSP_EvalPartition_Packed (job->soup, p, job->best_cost);
+
+		if (cost < job->best_cost)
+		{
+			job->best = p;
+			job->best_cost = cost;
+		}
+	}
+}
+
+static void BSP_PickNode_Job (void * data)
+{
+	BSP_PickNode_Range (data);
+}
+
 //
 // Evaluate *every* seg in the list as a partition candidate,
 // returning the best one, or NULL if none found (which means
 // the remaining segs form a subsector).
 //
-seg_t * BSP_PickNode_Slow (seg_t * soup)
+// [Woof!] large soups split the candidates among the worker threads.
+// ties are resolved in favor of the earlier seg, so the result is the
+// same as for a single sweep over the list.
+//
+seg_t * BSP_PickNode_Slow (seg_t * soup, int count)
 {
-	seg_t * part;
+	nanosoup_t packed;
+
+	BSP_PackSoup (soup, count, &packed);
+
+	int jobs = 1;
+
+	if (count >= PARALLEL_EVAL_THRESHOLD)
+		jobs = I_NumWorkerThreads () + 1;
+
+	picknode_job_t * pick = I_Realloc (NULL, jobs * sizeof(*pick));
+
+	int j;
+	for (j = 0 ; j < jobs ; j++)
+	{
+		pick[j].soup  = &packed;
+		pick[j].start = (int64_t)count * j / jobs;
+		pick[j].end   = (int64_t)count * (j + 1) / jobs;
+	}
+
+	if (jobs > 1)
+	{
+		jobgroup_t * group = I_CreateJobGroup ();
+
+		for (j = 1 ; j < jobs ; j++)
+			I_AddJob (group, BSP_PickNode_Job, &pick[j]);
+
+		BSP_PickNode_Range (&pick[0]);
+
+		I_WaitJobGroup (group);
+	}
+	else
+	{
+		BSP_PickNode_Range (&pick[0]);
+	}
+
 	seg_t * best  = NULL;
 	int best_cost = (1 << 30);
 
-	for (part = soup ; part != NULL ; part = part->next)
+	for (j = 0 ; j < jobs ; j++)
 	{
-		struct NodeEval eval;
-
-		if (BSP_EvalPartition (part, soup, &eval))
+		if (pick[j].best >= 0 && pick[j].best_cost < best_cost)
 		{
-			int cost = abs (eval.left - eval.right) * 2 + eval.split * SPLIT_COST;
-
-			if (cost < best_cost)
-			{
-				best = part;
-				best_cost = cost;
-			}
+			best = packed.segs[pick[j].best];
+			best_cost = pick[j].best_cost;
 		}
 	}
 
+	free (pick);
+	free (packed.segs);
+
 	return best;
 }
 
@@ -637,12 +852,40 @@ void BSP_SplitSegs (seg_t * part, seg_t * soup, seg_t ** lefts, seg_t ** rights)
 	}
 }
 
+int BSP_CountSegs (seg_t * soup)
+{
+	int count = 0;
+
+	seg_t * S;
+	for (S = soup ; S != NULL ; S = S->next)
+		count += 1;
+
+	return count;
+}
+
+nanode_t * BSP_SubdivideSegs (seg_t * soup);
+
+typedef struct
+{
+	seg_t * soup;
+	nanode_t * node;
+} subdivide_job_t;
+
+static void BSP_SubdivideJob (void * data)
+{
+	subdivide_job_t * job = data;
+
+	job->node = BSP_SubdivideSegs (job->soup);
+}
+
 nanode_t * BSP_SubdivideSegs (seg_t * soup)
 {
-	seg_t * part = BSP_PickNode_Fast (soup);
+	int count = BSP_CountSegs (soup);
+
+	seg_t * part = BSP_PickNode_Fast (soup, count);
 
 	if (part == NULL)
-		part = BSP_PickNode_Slow (soup);
+		part = BSP_PickNode_Slow (soup, count);
 
 	if (part == NULL)
 		return BSP_CreateLeaf (soup);
@@ -672,8 +915,28 @@ nanode_t * BSP_SubdivideSegs (seg_t * soup)
 
 	BSP_SplitSegs (part, soup, &lefts, &rights);
 
-	N->right = BSP_SubdivideSegs (rights);
-	N->left  = BSP_SubdivideSegs (lefts);
+	// [Woof!] the two halves are independent, so build the right one on
+	// another thread if both are large enough to be worth it.
+	if (I_NumWorkerThreads () > 0 &&
+		BSP_CountSegs (lefts)  >= PARALLEL_THRESHOLD &&
+		BSP_CountSegs (rights) >= PARALLEL_THRESHOLD)
+	{
+		jobgroup_t * group = I_CreateJobGroup ();
+		subdivide_job_t job = { rights, NULL };
+
+		I_AddJob (group, BSP_SubdivideJob, &job);
+
+		N->left = BSP_SubdivideSegs (lefts);
+
+		I_WaitJobGroup (group);
+
+		N->right = job.node;
+	}
+	else
+	{
+		N->right = BSP_SubdivideSegs (rights);
+		N->left  = BSP_SubdivideSegs (lefts);
+	}
 
 	return N;
 }
@@ -725,7 +988,7 @@ void BSP_WriteSubsector (nanode_t * N)
 		// copy and free it
 		memcpy (&segs[nano_seg_index], seg, sizeof(seg_t));
 
-		Z_Free (seg);
+		free (seg);
 
 		nano_seg_index += 1;
 		out->numlines  += 1;
@@ -763,13 +1026,322 @@ unsigned int BSP_WriteNode (nanode_t * N, fixed_t * bbox)
 		BSP_MergeBounds (bbox, out->bbox[0], out->bbox[1]);
 	}
 
-	Z_Free (N);
+	free (N);
 
 	return index;
 }
 
+//----------------------------------------------------------------------------
+//
+// [Woof!] node cache.  the output only depends on the vertices, lines
+// and sides of the map, so it is stored on disk keyed by their hash and
+// loaded from there the next time the map is played.
+//
+
+void BSP_InitCache (parsecache_t * cache)
+{
+	int * key = NULL;
+	int i;
+
+	array_push (key, NODE_CACHE_VERSION);
+
+	array_push (key, numvertexes);
+	for (i = 0 ; i < numvertexes ; i++)
+	{
+		array_push (key, vertexes[i].x);
+		array_push (key, vertexes[i].y);
+	}
+
+	array_push (key, numsides);
+	for (i = 0 ; i < numsides ; i++)
+		array_push (key, (int) (sides[i].sector - sectors));
+
+	array_push (key, numlines);
+	for (i = 0 ; i < numlines ; i++)
+	{
+		line_t * ld = &lines[i];
+
+		array_push (key, (int) (ld->v1 - vertexes));
+		array_push (key, (int) (ld->v2 - vertexes));
+		array_push (key, ld->sidenum[0]);
+		array_push (key, ld->sidenum[1]);
+		array_push (key, ld->frontsector ? (int) (ld->frontsector - sectors) : -1);
+		array_push (key, ld->backsector  ? (int) (ld->backsector  - sectors) : -1);
+	}
+
+	M_InitParseCache (cache, "nodes");
+	M_ParseCacheAddData (cache, key, array_size (key) * sizeof(*key));
+
+	array_free (key);
+}
+
+static int VertexRef (hashmap_t * refs, vertex_t * v)
+{
+	if (v >= vertexes && v < vertexes + numvertexes)
+		return (int) (v - vertexes);
+
+	return *(int *) hashmap_get (refs, (uintptr_t) v);
+}
+
+//
+// Every field is written with M_CacheWriteInt(), so the file is
+// little-endian and doesn't depend on the struct layout.
+//
+static void WriteCacheNode (MEMFILE * stream, const node_t * node)
+{
+	int side, box;
+
+	M_CacheWriteInt (stream, node->x);
+	M_CacheWriteInt (stream, node->y);
+	M_CacheWriteInt (stream, node->dx);
+	M_CacheWriteInt (stream, node->dy);
+
+	for (side = 0 ; side < 2 ; side++)
+		for (box = 0 ; box < 4 ; box++)
+			M_CacheWriteInt (stream, node->bbox[side][box]);
+
+	M_CacheWriteInt (stream, node->children[0]);
+	M_CacheWriteInt (stream, node->children[1]);
+}
+
+static boolean ReadCacheNode (MEMFILE * stream, node_t * node)
+{
+	boolean ok = M_CacheReadInt (stream, &node->x) &&
+	             M_CacheReadInt (stream, &node->y) &&
+	             M_CacheReadInt (stream, &node->dx) &&
+	             M_CacheReadInt (stream, &node->dy);
+	int side, box;
+
+	for (side = 0 ; ok && side < 2 ; side++)
+		for (box = 0 ; ok && box < 4 ; box++)
+			ok = M_CacheReadInt (stream, &node->bbox[side][box]);
+
+	return ok &&
+	       M_CacheReadInt (stream, &node->children[0]) &&
+	       M_CacheReadInt (stream, &node->children[1]);
+}
+
+void BSP_WriteCache (parsecache_t * cache)
+{
+	MEMFILE * stream = M_WriteParseCache (cache);
+
+	if (stream == NULL)
+		return;
+
+	int num_new = array_size (nano_vertices);
+	hashmap_t * refs = hashmap_init (num_new, sizeof(int));
+
+	M_CacheWriteInt (stream, NODE_CACHE_VERSION);
+	M_CacheWriteInt (stream, numnodes);
+	M_CacheWriteInt (stream, numsubsectors);
+	M_CacheWriteInt (stream, numsegs);
+	M_CacheWriteInt (stream, num_new);
+
+	int i;
+	for (i = 0 ; i < num_new ; i++)
+	{
+		int ref = numvertexes + i;
+
+		hashmap_put (refs, (uintptr_t) nano_vertices[i], &ref);
+
+		M_CacheWriteInt (stream, nano_vertices[i]->x);
+		M_CacheWriteInt (stream, nano_vertices[i]->y);
+	}
+
+	for (i = 0 ; i < numnodes ; i++)
+		WriteCacheNode (stream, &nodes[i]);
+
+	for (i = 0 ; i < numsubsectors ; i++)
+	{
+		M_CacheWriteInt (stream, subsectors[i].firstline);
+		M_CacheWriteInt (stream, subsectors[i].numlines);
+	}
+
+	for (i = 0 ; i < numsegs ; i++)
+	{
+		seg_t * seg = &segs[i];
+
+		M_CacheWriteInt (stream, VertexRef (refs, seg->v1));
+		M_CacheWriteInt (stream, VertexRef (refs, seg->v2));
+		M_CacheWriteInt (stream, seg->offset);
+		M_CacheWriteInt (stream, seg->angle);
+		M_CacheWriteInt (stream, (int) (seg->linedef - lines));
+		M_CacheWriteInt (stream, (int) (seg->sidedef - sides));
+		M_CacheWriteInt (stream, (int) (seg->frontsector - sectors));
+		M_CacheWriteInt (stream, seg->backsector ? (int) (seg->backsector - sectors) : -1);
+	}
+
+	hashmap_free (refs);
+}
+
+static boolean ReadIndex (MEMFILE * stream, int * value, int min, int max)
+{
+	return M_CacheReadInt (stream, value) && *value >= min && *value < max;
+}
+
+typedef struct
+{
+	int v1, v2, offset, angle, line, side, front, back;
+} cacheseg_t;
+
+//
+// The whole file is read and checked into temporary buffers first, so a
+// corrupt cache file allocates nothing in the zone or in the world arena
+// and the caller can build the nodes from scratch.
+//
+boolean BSP_ReadCache (parsecache_t * cache)
+{
+	MEMFILE * stream = M_ReadParseCache (cache);
+
+	if (stream == NULL)
+		return false;
+
+	int version, num_new;
+
+	if (!M_CacheReadInt (stream, &version) ||
+		version != NODE_CACHE_VERSION ||
+		!M_CacheReadInt (stream, &numnodes) ||
+		!M_CacheReadInt (stream, &numsubsectors) ||
+		!M_CacheReadInt (stream, &numsegs) ||
+		!M_CacheReadInt (stream, &num_new) ||
+		numsubsectors <= 0 || numnodes != numsubsectors - 1 ||
+		numsegs < numsubsectors || numsegs > (1 << 28) ||
+		num_new < 0 || num_new > numsegs * 2)
+	{
+		return false;
+	}
+
+	// the rest of the file must hold exactly what the header announces,
+	// so a bogus header can't make us allocate huge scratch buffers
+	void * buffer;
+	size_t length;
+
+	mem_get_buf (stream, &buffer, &length);
+
+	const size_t expected = (size_t) num_new * 2 * sizeof(int) +
+	                        (size_t) numnodes * NODE_CACHE_FIELDS * sizeof(int) +
+	                        (size_t) numsubsectors * 2 * sizeof(int) +
+	                        (size_t) numsegs * 8 * sizeof(int);
+
+	if (length - (size_t) mem_ftell (stream) != expected)
+		return false;
+
+	int * new_xy = I_Realloc (NULL, (num_new * 2 + 1) * sizeof(int));
+	node_t * new_nodes = I_Realloc (NULL, (numnodes + 1) * sizeof(node_t));
+	int * new_ss = I_Realloc (NULL, numsubsectors * 2 * sizeof(int));
+	cacheseg_t * new_segs = I_Realloc (NULL, numsegs * sizeof(cacheseg_t));
+
+	boolean ok = true;
+
+	int i;
+	for (i = 0 ; ok && i < num_new * 2 ; i++)
+		ok = M_CacheReadInt (stream, &new_xy[i]);
+
+	for (i = 0 ; ok && i < numnodes ; i++)
+		ok = ReadCacheNode (stream, &new_nodes[i]);
+
+	for (i = 0 ; ok && i < numsubsectors ; i++)
+	{
+		int * ss = &new_ss[i * 2];
+
+		ok = ReadIndex (stream, &ss[0], 0, numsegs) &&
+		     ReadIndex (stream, &ss[1], 1, numsegs - ss[0] + 1);
+	}
+
+	for (i = 0 ; ok && i < numsegs ; i++)
+	{
+		cacheseg_t * cs = &new_segs[i];
+
+		ok = ReadIndex (stream, &cs->v1, 0, numvertexes + num_new) &&
+		     ReadIndex (stream, &cs->v2, 0, numvertexes + num_new) &&
+		     M_CacheReadInt (stream, &cs->offset) &&
+		     M_CacheReadInt (stream, &cs->angle) &&
+		     ReadIndex (stream, &cs->line,  0, numlines) &&
+		     ReadIndex (stream, &cs->side,  0, numsides) &&
+		     ReadIndex (stream, &cs->front, 0, numsectors) &&
+		     ReadIndex (stream, &cs->back, -1, numsectors);
+	}
+
+	for (i = 0 ; ok && i < numnodes ; i++)
+	{
+		int c;
+		for (c = 0 ; c < 2 ; c++)
+		{
+			unsigned int child = new_nodes[i].children[c];
+
+			if (child & NF_SUBSECTOR)
+				ok &= (child & ~NF_SUBSECTOR) < (unsigned int) numsubsectors;
+			else
+				ok &= child < (unsigned int) i;
+		}
+	}
+
+	if (ok)
+	{
+		vertex_t ** new_vertices = I_Realloc (NULL, (num_new + 1) * sizeof(vertex_t *));
+
+		for (i = 0 ; i < num_new ; i++)
+			new_vertices[i] = BSP_NewVertex (new_xy[i * 2], new_xy[i * 2 + 1]);
+
+		nodes      = Z_Malloc (numnodes*sizeof(node_t), PU_LEVEL, NULL);
+		subsectors = arena_alloc_num (world_arena, subsector_t, numsubsectors);
+		segs       = arena_alloc_num (world_arena, seg_t, numsegs);
+
+		memcpy (nodes, new_nodes, numnodes * sizeof(node_t));
+		memset (subsectors, 0, numsubsectors*sizeof(subsector_t));
+		memset (segs, 0, numsegs*sizeof(seg_t));
+
+		for (i = 0 ; i < numsubsectors ; i++)
+		{
+			subsectors[i].firstline = new_ss[i * 2];
+			subsectors[i].numlines  = new_ss[i * 2 + 1];
+		}
+
+		for (i = 0 ; i < numsegs ; i++)
+		{
+			const cacheseg_t * cs = &new_segs[i];
+			seg_t * seg = &segs[i];
+
+			seg->v1 = (cs->v1 < numvertexes) ? &vertexes[cs->v1] : new_vertices[cs->v1 - numvertexes];
+			seg->v2 = (cs->v2 < numvertexes) ? &vertexes[cs->v2] : new_vertices[cs->v2 - numvertexes];
+			seg->offset      = cs->offset;
+			seg->angle       = cs->angle;
+			seg->linedef     = &lines[cs->line];
+			seg->sidedef     = &sides[cs->side];
+			seg->frontsector = &sectors[cs->front];
+			seg->backsector  = (cs->back < 0) ? NULL : &sectors[cs->back];
+		}
+
+		free (new_vertices);
+	}
+
+	free (new_xy);
+	free (new_nodes);
+	free (new_ss);
+	free (new_segs);
+
+	return ok;
+}
+
 void BSP_BuildNodes (void)
 {
+	parsecache_t cache;
+
+	if (vertex_mutex == NULL)
+		vertex_mutex = I_CreateMutex ();
+
+	BSP_InitCache (&cache);
+
+	if (BSP_ReadCache (&cache))
+	{
+		I_Printf (VB_DEBUG, "BSP_BuildNodes: loaded nodes from cache");
+		M_CloseParseCache (&cache, false);
+		array_clear (nano_vertices);
+		return;
+	}
+
+	array_clear (nano_vertices);
+
 	seg_t * list = BSP_CreateSegs ();
 
 	nanode_t * root = BSP_SubdivideSegs (list);
@@ -799,4 +1371,9 @@ void BSP_BuildNodes (void)
 
 	// this also frees stuff as it goes
 	BSP_WriteNode (root, dummy);
+
+	BSP_WriteCache (&cache);
+	M_CloseParseCache (&cache, true);
+
+	array_clear (nano_vertices);
 }
@@ -17,9 +17,13 @@
 
 #include "doomdata.h"
 #include "doomtype.h"
+#include "i_printf.h"
+#include "i_thread.h"
 #include "m_arena.h"
 #include "m_argv.h"
+#include "m_array.h"
 #include "m_fixed.h"
+#include "m_parsecache.h"
 #include "m_swap.h"
 #include "p_mobj.h"
 #include "p_setup.h"
@@ -27,6 +31,8 @@
 #include "w_wad.h"
 #include "z_zone.h"
 #include <limits.h>
+#include <stdlib.h>
+#include <string.h>
 
 const char *bmap_format_names[] = {
     "",
@@ -50,48 +56,399 @@ const char *bmap_format_names[] = {
 
 // jff 10/8/98 use guardband>0
 // jff 10/12/98 0 ok with + 1 in rows,cols
-typedef struct linelist_t // type used to list lines in each block
+
+// [Woof!] The lines are split into ranges that are rasterized in parallel.
+// The first pass collects the blocks touched by each line and counts the
+// lines of each block per range, the second pass writes the lines straight
+// into the blockmap lump. The lists come out exactly as with the former
+// linked lists: 0, the lines in descending order, -1.
+//
+// The header is known right away, and large maps are rasterized in the
+// background while the level setup goes on. The line coordinates are copied
+// first, since the node loaders may still move the vertexes.
+
+#define PARALLEL_THRESHOLD 4096
+
+// upper limit for the per range block counters
+#define MAX_COUNT_MEMORY (64 * 1024 * 1024)
+
+typedef struct
+{
+    int first, last;  // range of lines
+    int *count;       // number of lines in each block
+    int *blocks;      // blocks touched by each line, one after the other
+    int *line_start;  // index into `blocks` for each line, plus one
+} bmapjob_t;
+
+typedef struct
+{
+    int x1, y1, x2, y2; // map coords
+} bmapline_t;
+
+static int xorg, yorg;   // blockmap origin (lower left)
+static int nrows, ncols; // blockmap dimensions
+static int NBlocks;      // number of cells = nrows*ncols
+
+static bmapline_t *bmaplines;
+static int32_t *new_blockmaplump; // malloc'd, copied to the zone when done
+static int new_blockmaplump_size;
+static jobgroup_t *build_group;
+
+static int CompareBlocks(const void *a, const void *b)
 {
-    int num;
-    struct linelist_t *next;
-} linelist_t;
+    return *(const int *)a - *(const int *)b;
+}
 
 //
-// Subroutine to add a line number to a block list
-// It simply returns if the line is already in the block
+// Subroutine to add all blocks touched by a line to the job's list
+// Every block is added only once
 //
-static void AddBlockLine(linelist_t **lists, int *count, int *done, int blockno,
-                         int lineno)
+static void AddLineBlocks(bmapjob_t *job, int i)
+{
+    int x1 = bmaplines[i].x1; // lines[i] map coords
+    int y1 = bmaplines[i].y1;
+    int x2 = bmaplines[i].x2;
+    int y2 = bmaplines[i].y2;
+    int dx = x2 - x1;
+    int dy = y2 - y1;
+    int vert = !dx; // lines[i] slopetype
+    int horiz = !dy;
+    int spos = (dx ^ dy) > 0;
+    int sneg = (dx ^ dy) < 0;
+    int bx, by;                   // block cell coords
+    int minx = x1 > x2 ? x2 : x1; // extremal lines[i] coords
+    int maxx = x1 > x2 ? x1 : x2;
+    int miny = y1 > y2 ? y2 : y1;
+    int maxy = y1 > y2 ? y1 : y2;
+    int start = array_size(job->blocks);
+    int j, k, n;
+
+    // The line always belongs to the blocks containing its endpoints
+
+    bx = (x1 - xorg) >> blkshift;
+    by = (y1 - yorg) >> blkshift;
+    array_push(job->blocks, by * ncols + bx);
+    bx = (x2 - xorg) >> blkshift;
+    by = (y2 - yorg) >> blkshift;
+    array_push(job->blocks, by * ncols + bx);
+
+    // For each column, see where the line aint its left edge, which
+    // it contains, intersects the Linedef i. Add i to each corresponding
+    // blocklist.
+
+    if (!vert) // don't interesect vertical lines with columns
+    {
+        // only the columns between the endpoints can intersect the line
+        int jmin = MAX(0, (minx - xorg + blkmask) >> blkshift);
+        int jmax = MIN(ncols - 1, (maxx - xorg) >> blkshift);
+
+        for (j = jmin; j <= jmax; j++)
+        {
+            // intersection of Linedef with x=xorg+(j<<blkshift)
+            // (y-y1)*dx = dy*(x-x1)
+            // y = dy*(x-x1)+y1*dx;
+
+            int x = xorg + (j << blkshift); // (x,y) is intersection
+            int y = (dy * (x - x1)) / dx + y1;
+            int yb = (y - yorg) >> blkshift; // block row number
+            int yp = (y - yorg) & blkmask;   // y position within block
+
+            if (yb < 0 || yb > nrows - 1) // outside blockmap, continue
+            {
+                continue;
+            }
+
+            if (x < minx || x > maxx) // line doesn't touch column
+            {
+                continue;
+            }
+
+            // The cell that contains the intersection point is always added
+
+            array_push(job->blocks, ncols * yb + j);
+
+            // if the intersection is at a corner it depends on the slope
+            // (and whether the line extends past the intersection) which
+            // blocks are hit
+
+            if (yp == 0) // intersection at a corner
+            {
+                if (sneg) //   \ - blocks x,y-, x-,y
+                {
+                    if (yb > 0 && miny < y)
+                    {
+                        array_push(job->blocks, ncols * (yb - 1) + j);
+                    }
+                    if (j > 0 && minx < x)
+                    {
+                        array_push(job->blocks, ncols * yb + j - 1);
+                    }
+                }
+                else if (spos) //   / - block x-,y-
+                {
+                    if (yb > 0 && j > 0 && minx < x)
+                    {
+                        array_push(job->blocks, ncols * (yb - 1) + j - 1);
+                    }
+                }
+                else if (horiz) //   - - block x-,y
+                {
+                    if (j > 0 && minx < x)
+                    {
+                        array_push(job->blocks, ncols * yb + j - 1);
+                    }
+                }
+            }
+            else if (j > 0 && minx < x) // else not at corner: x-,y
+            {
+                array_push(job->blocks, ncols * yb + j - 1);
+            }
+        }
+    }
+
+    // For each row, see where the line aint its bottom edge, which
+    // it contains, intersects the Linedef i. Add i to all the corresponding
+    // blocklists.
+
+    if (!horiz)
+    {
+        // only the rows between the endpoints can intersect the line
+        int jmin = MAX(0, (miny - yorg + blkmask) >> blkshift);
+        int jmax = MIN(nrows - 1, (maxy - yorg) >> blkshift);
+
+        for (j = jmin; j <= jmax; j++)
+        {
+            // intersection of Linedef with y=yorg+(j<<blkshift)
+            // (x,y) on Linedef i satisfies: (y-y1)*dx = dy*(x-x1)
+            // x = dx*(y-y1)/dy+x1;
+
+            int y = yorg + (j << blkshift); // (x,y) is intersection
+            int x = (dx * (y - y1)) / dy + x1;
+            int xb = (x - xorg) >> blkshift; // block column number
+            int xp = (x - xorg) & blkmask;   // x position within block
+
+            if (xb < 0 || xb > ncols - 1) // outside blockmap, continue
+            {
+                continue;
+            }
+
+            if (y < miny || y > maxy) // line doesn't touch row
+            {
+                continue;
+            }
+
+            // The cell that contains the intersection point is always added
+
+            array_push(job->blocks, ncols * j + xb);
+
+            // if the intersection is at a corner it depends on the slope
+            // (and whether the line extends past the intersection) which
+            // blocks are hit
+
+            if (xp == 0) // intersection at a corner
+            {
+                if (sneg) //   \ - blocks x,y-, x-,y
+                {
+                    if (j > 0 && miny < y)
+                    {
+                        array_push(job->blocks, ncols * (j - 1) + xb);
+                    }
+                    if (xb > 0 && minx < x)
+                    {
+                        array_push(job->blocks, ncols * j + xb - 1);
+                    }
+                }
+                else if (vert) //   | - block x,y-
+                {
+                    if (j > 0 && miny < y)
+                    {
+                        array_push(job->blocks, ncols * (j - 1) + xb);
+                    }
+                }
+                else if (spos) //   / - block x-,y-
+                {
+                    if (xb > 0 && j > 0 && miny < y)
+                    {
+                        array_push(job->blocks, ncols * (j - 1) + xb - 1);
+                    }
+                }
+            }
+            else if (j > 0 && miny < y) // else not on a corner: x,y-
+            {
+                array_push(job->blocks, ncols * (j - 1) + xb);
+            }
+        }
+    }
+
+    // remove duplicates, the column and row passes often hit the same blocks
+
+    n = array_size(job->blocks) - start;
+    qsort(job->blocks + start, n, sizeof(*job->blocks), CompareBlocks);
+
+    for (j = 0, k = 0; j < n; j++)
+    {
+        if (k == 0 || job->blocks[start + k - 1] != job->blocks[start + j])
+        {
+            job->blocks[start + k++] = job->blocks[start + j];
+        }
+    }
+
+    array_resize(job->blocks, start + k);
+}
+
+static void CountBlockLines(void *data)
 {
-    linelist_t *l;
+    bmapjob_t *job = data;
+    int i, j;
+
+    job->count = calloc(NBlocks, sizeof(*job->count));
+    job->line_start = malloc((job->last - job->first + 1)
+                             * sizeof(*job->line_start));
 
-    if (done[blockno])
+    for (i = job->first; i < job->last; i++)
     {
+        job->line_start[i - job->first] = array_size(job->blocks);
+        AddLineBlocks(job, i);
+    }
+    job->line_start[job->last - job->first] = array_size(job->blocks);
+
+    for (j = 0; j < array_size(job->blocks); j++)
+    {
+        job->count[job->blocks[j]]++;
+    }
+}
+
+// On entry, `count` holds the position of the range's first line in each
+// block. The lines are written in descending order.
+
+static void FillBlockLines(void *data)
+{
+    bmapjob_t *job = data;
+    int *cursor = job->count;
+    int i, j;
+
+    for (i = job->last - 1; i >= job->first; i--)
+    {
+        for (j = job->line_start[i - job->first];
+             j < job->line_start[i - job->first + 1]; j++)
+        {
+            new_blockmaplump[cursor[job->blocks[j]]++] = i;
+        }
+    }
+
+    free(job->count);
+    free(job->line_start);
+    array_free(job->blocks);
+}
+
+static void RunJobs(bmapjob_t *jobs, int num_jobs, jobfunc_t func)
+{
+    if (num_jobs == 1)
+    {
+        func(&jobs[0]);
         return;
     }
 
-    l = Z_Malloc(sizeof(linelist_t), PU_STATIC, 0);
-    l->num = lineno;
-    l->next = lists[blockno];
-    lists[blockno] = l;
-    count[blockno]++;
-    done[blockno] = 1;
+    jobgroup_t *group = I_CreateJobGroup();
+
+    for (int i = 0; i < num_jobs; i++)
+    {
+        I_AddJob(group, func, &jobs[i]);
+    }
+
+    I_WaitJobGroup(group);
 }
 
-static void P_CreateBlockMap(void)
+static void BuildBlockMap(void *data)
+{
+    bmapjob_t *jobs;
+    int num_jobs = 1;
+    int linetotal; // total length of all blocklists
+    int i, j;
+
+    (void)data;
+
+    // split the lines into ranges, as long as the counters fit
+
+    if (numlines >= PARALLEL_THRESHOLD && I_NumWorkerThreads() > 0)
+    {
+        num_jobs = (I_NumWorkerThreads() + 1) * 2;
+        num_jobs = MIN(num_jobs, numlines / (PARALLEL_THRESHOLD / 4));
+        num_jobs = MIN(num_jobs, MAX_COUNT_MEMORY / (NBlocks * (int)sizeof(int)));
+        num_jobs = MAX(num_jobs, 1);
+    }
+
+    jobs = calloc(num_jobs, sizeof(*jobs));
+
+    for (i = 0; i < num_jobs; i++)
+    {
+        jobs[i].first = (int64_t)numlines * i / num_jobs;
+        jobs[i].last = (int64_t)numlines * (i + 1) / num_jobs;
+    }
+
+    // For each linedef in the wad, determine all blockmap blocks it touches
+
+    RunJobs(jobs, num_jobs, CountBlockLines);
+
+    // count the total number of lines, every list starts with 0 and
+    // ends with -1
+
+    linetotal = 0;
+    for (i = 0; i < num_jobs; i++)
+    {
+        linetotal += array_size(jobs[i].blocks);
+    }
+    linetotal += 2 * NBlocks;
+
+    // Create the blockmap lump
+
+    new_blockmaplump_size = 4 + NBlocks + linetotal;
+    new_blockmaplump =
+        malloc(sizeof(*new_blockmaplump) * new_blockmaplump_size);
+
+    // blockmap header
+
+    new_blockmaplump[0] = IntToFixed(xorg);
+    new_blockmaplump[1] = IntToFixed(yorg);
+    new_blockmaplump[2] = ncols;
+    new_blockmaplump[3] = nrows;
+
+    // offsets to lists, and the position of each range within the lists;
+    // the last range holds the highest line numbers and comes first
+
+    for (i = 0, linetotal = 4 + NBlocks; i < NBlocks; i++)
+    {
+        int offs = new_blockmaplump[4 + i] = linetotal;
+
+        new_blockmaplump[offs++] = 0;
+
+        for (j = num_jobs - 1; j >= 0; j--)
+        {
+            int count = jobs[j].count[i];
+            jobs[j].count[i] = offs;
+            offs += count;
+        }
+
+        new_blockmaplump[offs++] = -1;
+        linetotal = offs;
+    }
+
+    // add the lines in each block's list to the blockmaplump
+
+    RunJobs(jobs, num_jobs, FillBlockLines);
+
+    free(jobs);
+    free(bmaplines);
+    bmaplines = NULL;
+}
+
+static void StartCreateBlockMap(void)
 {
-    int xorg, yorg;                 // blockmap origin (lower left)
-    int nrows, ncols;               // blockmap dimensions
-    linelist_t **blocklists = NULL; // array of pointers to lists of lines
-    int *blockcount = NULL;         // array of counters of line lists
-    int *blockdone = NULL;          // array keeping track of blocks/line
-    int NBlocks;                    // number of cells = nrows*ncols
-    int linetotal = 0;              // total length of all blocklists
-    int map_minx = INT_MAX;         // init for map limits search
+    int map_minx = INT_MAX; // init for map limits search
     int map_miny = INT_MAX;
     int map_maxx = INT_MIN;
     int map_maxy = INT_MIN;
-    int i, j;
+    int i;
 
     // scan for map limits, which the blockmap must enclose
 
@@ -140,263 +497,48 @@ static void P_CreateBlockMap(void)
     // map exactly 1 cell
     NBlocks = ncols * nrows;
 
-    // create the array of pointers on NBlocks to blocklists
-    // also create an array of linelist counts on NBlocks
-    // finally make an array in which we can mark blocks done per line
+    bmaporgx = IntToFixed(xorg);
+    bmaporgy = IntToFixed(yorg);
+    bmapwidth = ncols;
+    bmapheight = nrows;
 
-    // CPhipps - calloc's
-    blocklists = Z_Calloc(NBlocks, sizeof(linelist_t *), PU_STATIC, 0);
-    blockcount = Z_Calloc(NBlocks, sizeof(int), PU_STATIC, 0);
-    blockdone = Z_Malloc(NBlocks * sizeof(int), PU_STATIC, 0);
+    bmaplines = malloc(numlines * sizeof(*bmaplines));
 
-    // initialize each blocklist, and enter the trailing -1 in all blocklists
-    // note the linked list of lines grows backwards
-
-    for (i = 0; i < NBlocks; i++)
+    for (i = 0; i < numlines; i++)
     {
-        blocklists[i] = Z_Malloc(sizeof(linelist_t), PU_STATIC, 0);
-        blocklists[i]->num = -1;
-        blocklists[i]->next = NULL;
-        blockcount[i]++;
+        bmaplines[i].x1 = lines[i].v1->x >> FRACBITS;
+        bmaplines[i].y1 = lines[i].v1->y >> FRACBITS;
+        bmaplines[i].x2 = lines[i].v2->x >> FRACBITS;
+        bmaplines[i].y2 = lines[i].v2->y >> FRACBITS;
     }
 
-    // For each linedef in the wad, determine all blockmap blocks it touches,
-    // and add the linedef number to the blocklists for those blocks
-
-    for (i = 0; i < numlines; i++)
+    if (numlines >= PARALLEL_THRESHOLD && I_NumWorkerThreads() > 0)
     {
-        int x1 = lines[i].v1->x >> FRACBITS; // lines[i] map coords
-        int y1 = lines[i].v1->y >> FRACBITS;
-        int x2 = lines[i].v2->x >> FRACBITS;
-        int y2 = lines[i].v2->y >> FRACBITS;
-        int dx = x2 - x1;
-        int dy = y2 - y1;
-        int vert = !dx; // lines[i] slopetype
-        int horiz = !dy;
-        int spos = (dx ^ dy) > 0;
-        int sneg = (dx ^ dy) < 0;
-        int bx, by;                   // block cell coords
-        int minx = x1 > x2 ? x2 : x1; // extremal lines[i] coords
-        int maxx = x1 > x2 ? x1 : x2;
-        int miny = y1 > y2 ? y2 : y1;
-        int maxy = y1 > y2 ? y1 : y2;
-
-        // no blocks done for this linedef yet
-
-        memset(blockdone, 0, NBlocks * sizeof(int));
-
-        // The line always belongs to the blocks containing its endpoints
-
-        bx = (x1 - xorg) >> blkshift;
-        by = (y1 - yorg) >> blkshift;
-        AddBlockLine(blocklists, blockcount, blockdone, by * ncols + bx, i);
-        bx = (x2 - xorg) >> blkshift;
-        by = (y2 - yorg) >> blkshift;
-        AddBlockLine(blocklists, blockcount, blockdone, by * ncols + bx, i);
-
-        // For each column, see where the line aint its left edge, which
-        // it contains, intersects the Linedef i. Add i to each corresponding
-        // blocklist.
-
-        if (!vert) // don't interesect vertical lines with columns
-        {
-            for (j = 0; j < ncols; j++)
-            {
-                // intersection of Linedef with x=xorg+(j<<blkshift)
-                // (y-y1)*dx = dy*(x-x1)
-                // y = dy*(x-x1)+y1*dx;
-
-                int x = xorg + (j << blkshift); // (x,y) is intersection
-                int y = (dy * (x - x1)) / dx + y1;
-                int yb = (y - yorg) >> blkshift; // block row number
-                int yp = (y - yorg) & blkmask;   // y position within block
-
-                if (yb < 0 || yb > nrows - 1) // outside blockmap, continue
-                {
-                    continue;
-                }
-
-                if (x < minx || x > maxx) // line doesn't touch column
-                {
-                    continue;
-                }
-
-                // The cell that contains the intersection point is always added
-
-                AddBlockLine(blocklists, blockcount, blockdone, ncols * yb + j,
-                             i);
-
-                // if the intersection is at a corner it depends on the slope
-                // (and whether the line extends past the intersection) which
-                // blocks are hit
-
-                if (yp == 0) // intersection at a corner
-                {
-                    if (sneg) //   \ - blocks x,y-, x-,y
-                    {
-                        if (yb > 0 && miny < y)
-                        {
-                            AddBlockLine(blocklists, blockcount, blockdone,
-                                         ncols * (yb - 1) + j, i);
-                        }
-                        if (j > 0 && minx < x)
-                        {
-                            AddBlockLine(blocklists, blockcount, blockdone,
-                                         ncols * yb + j - 1, i);
-                        }
-                    }
-                    else if (spos) //   / - block x-,y-
-                    {
-                        if (yb > 0 && j > 0 && minx < x)
-                        {
-                            AddBlockLine(blocklists, blockcount, blockdone,
-                                         ncols * (yb - 1) + j - 1, i);
-                        }
-                    }
-                    else if (horiz) //   - - block x-,y
-                    {
-                        if (j > 0 && minx < x)
-                        {
-                            AddBlockLine(blocklists, blockcount, blockdone,
-                                         ncols * yb + j - 1, i);
-                        }
-                    }
-                }
-                else if (j > 0 && minx < x) // else not at corner: x-,y
-                {
-                    AddBlockLine(blocklists, blockcount, blockdone,
-                                 ncols * yb + j - 1, i);
-                }
-            }
-        }
-
-        // For each row, see where the line aint its bottom edge, which
-        // it contains, intersects the Linedef i. Add i to all the corresponding
-        // blocklists.
-
-        if (!horiz)
-        {
-            for (j = 0; j < nrows; j++)
-            {
-                // intersection of Linedef with y=yorg+(j<<blkshift)
-                // (x,y) on Linedef i satisfies: (y-y1)*dx = dy*(x-x1)
-                // x = dx*(y-y1)/dy+x1;
-
-                int y = yorg + (j << blkshift); // (x,y) is intersection
-                int x = (dx * (y - y1)) / dy + x1;
-                int xb = (x - xorg) >> blkshift; // block column number
-                int xp = (x - xorg) & blkmask;   // x position within block
-
-                if (xb < 0 || xb > ncols - 1) // outside blockmap, continue
-                {
-                    continue;
-                }
-
-                if (y < miny || y > maxy) // line doesn't touch row
-                {
-                    continue;
-                }
-
-                // The cell that contains the intersection point is always added
-
-                AddBlockLine(blocklists, blockcount, blockdone, ncols * j + xb,
-                             i);
-
-                // if the intersection is at a corner it depends on the slope
-                // (and whether the line extends past the intersection) which
-                // blocks are hit
-
-                if (xp == 0) // intersection at a corner
-                {
-                    if (sneg) //   \ - blocks x,y-, x-,y
-                    {
-                        if (j > 0 && miny < y)
-                        {
-                            AddBlockLine(blocklists, blockcount, blockdone,
-                                         ncols * (j - 1) + xb, i);
-                        }
-                        if (xb > 0 && minx < x)
-                        {
-                            AddBlockLine(blocklists, blockcount, blockdone,
-                                         ncols * j + xb - 1, i);
-                        }
-                    }
-                    else if (vert) //   | - block x,y-
-                    {
-                        if (j > 0 && miny < y)
-                        {
-                            AddBlockLine(blocklists, blockcount, blockdone,
-                                         ncols * (j - 1) + xb, i);
-                        }
-                    }
-                    else if (spos) //   / - block x-,y-
-                    {
-                        if (xb > 0 && j > 0 && miny < y)
-                        {
-                            AddBlockLine(blocklists, blockcount, blockdone,
-                                         ncols * (j - 1) + xb - 1, i);
-                        }
-                    }
-                }
-                else if (j > 0 && miny < y) // else not on a corner: x,y-
-                {
-                    AddBlockLine(blocklists, blockcount, blockdone,
-                                 ncols * (j - 1) + xb, i);
-                }
-            }
-        }
+        build_group = I_CreateJobGroup();
+        I_AddJob(build_group, BuildBlockMap, NULL);
     }
-
-    // Add initial 0 to all blocklists
-    // count the total number of lines (and 0's and -1's)
-
-    memset(blockdone, 0, NBlocks * sizeof(int));
-    for (i = 0, linetotal = 0; i < NBlocks; i++)
+    else
     {
-        AddBlockLine(blocklists, blockcount, blockdone, i, 0);
-        linetotal += blockcount[i];
+        BuildBlockMap(NULL);
     }
+}
 
-    // Create the blockmap lump
-
-    // blockmaplump = malloc_IfSameLevel(blockmaplump, sizeof(*blockmaplump) *
-    // (4 + NBlocks + linetotal));
-    blockmaplump = Z_Malloc(sizeof(*blockmaplump) * (4 + NBlocks + linetotal),
-                            PU_LEVEL, 0);
-
-    // blockmap header
-
-    blockmaplump[0] = bmaporgx = IntToFixed(xorg);
-    blockmaplump[1] = bmaporgy = IntToFixed(yorg);
-    blockmaplump[2] = bmapwidth = ncols;
-    blockmaplump[3] = bmapheight = nrows;
-
-    // offsets to lists and block lists
-
-    for (i = 0; i < NBlocks; i++)
+static void FinishCreateBlockMap(void)
+{
+    if (build_group)
     {
-        linelist_t *bl = blocklists[i];
-        int offs = blockmaplump[4 + i] = // set offset to block's list
-            (i ? blockmaplump[4 + i - 1] : 4 + NBlocks)
-            + (i ? blockcount[i - 1] : 0);
-
-        // add the lines in each block's list to the blockmaplump
-        // delete each list node as we go
-
-        while (bl)
-        {
-            linelist_t *tmp = bl->next;
-            blockmaplump[offs++] = bl->num;
-            Z_Free(bl);
-            bl = tmp;
-        }
+        I_WaitJobGroup(build_group);
+        build_group = NULL;
     }
 
-    // free all temporary storage
+    blockmaplump_size = new_blockmaplump_size;
+    blockmaplump = Z_Malloc(sizeof(*blockmaplump) * blockmaplump_size,
+                            PU_LEVEL, 0);
+    memcpy(blockmaplump, new_blockmaplump,
+           sizeof(*blockmaplump) * blockmaplump_size);
 
-    Z_Free(blocklists);
-    Z_Free(blockcount);
-    Z_Free(blockdone);
+    free(new_blockmaplump);
+    new_blockmaplump = NULL;
 }
 
 #else // MBF_STRICT
@@ -577,6 +719,7 @@ static void P_CreateBlockMap(void)
 
             // Allocate blockmap lump with computed count
             blockmaplump = Z_Malloc(sizeof(*blockmaplump) * count, PU_LEVEL, 0);
+            blockmaplump_size = count;
         }
 
         // Now compress the blockmap.
@@ -615,8 +758,168 @@ static void P_CreateBlockMap(void)
     }
 }
 
+static void StartCreateBlockMap(void)
+{
+    P_CreateBlockMap();
+}
+
+static void FinishCreateBlockMap(void)
+{
+}
+
 #endif // MBF_STRICT
 
+// [Woof!] Built blockmaps only depend on the vertices and lines, so they are
+// cached on disk like the nodes. All fields are stored little-endian, like
+// every other int of the parse cache, and the version in the header says so.
+
+#define BLOCKMAP_CACHE_VERSION 2
+
+static void InitBlockMapCache(parsecache_t *cache)
+{
+    int *key = NULL;
+
+    array_push(key, BLOCKMAP_CACHE_VERSION);
+#ifdef MBF_STRICT
+    array_push(key, 1);
+#else
+    array_push(key, 0);
+#endif
+
+    array_push(key, numvertexes);
+    for (int i = 0; i < numvertexes; i++)
+    {
+        array_push(key, vertexes[i].x);
+        array_push(key, vertexes[i].y);
+    }
+
+    array_push(key, numlines);
+    for (int i = 0; i < numlines; i++)
+    {
+        array_push(key, (int)(lines[i].v1 - vertexes));
+        array_push(key, (int)(lines[i].v2 - vertexes));
+    }
+
+    M_InitParseCache(cache, "blockmap");
+    M_ParseCacheAddData(cache, key, array_size(key) * sizeof(*key));
+
+    array_free(key);
+}
+
+static boolean ReadBlockMapCache(parsecache_t *cache)
+{
+    MEMFILE *stream = M_ReadParseCache(cache);
+    int version, count;
+
+    if (stream == NULL || !M_CacheReadInt(stream, &version)
+        || version != BLOCKMAP_CACHE_VERSION || !M_CacheReadInt(stream, &count)
+        || count < 4 || count > (1 << 28))
+    {
+        return false;
+    }
+
+    // the rest of the file must hold exactly the announced fields
+    void *buffer;
+    size_t length;
+
+    mem_get_buf(stream, &buffer, &length);
+
+    if (length - (size_t)mem_ftell(stream) != sizeof(int) * (size_t)count)
+    {
+        return false;
+    }
+
+    blockmaplump = Z_Malloc(sizeof(*blockmaplump) * count, PU_LEVEL, 0);
+
+    for (int i = 0; i < count; i++)
+    {
+        int value;
+
+        if (!M_CacheReadInt(stream, &value))
+        {
+            Z_Free(blockmaplump);
+            return false;
+        }
+
+        blockmaplump[i] = value;
+    }
+
+    // every offset must point to a list within the lump, and the last list
+    // must be terminated, so that no list runs past the end
+
+    const int width = blockmaplump[2], height = blockmaplump[3];
+    boolean ok = width > 0 && height > 0 && width <= count / height
+                 && 4 + width * height < count && blockmaplump[count - 1] == -1;
+
+    for (int i = 4; ok && i < 4 + width * height; i++)
+    {
+        ok = blockmaplump[i] >= 4 + width * height && blockmaplump[i] < count;
+    }
+
+    for (int i = 4 + width * height; ok && i < count; i++)
+    {
+        ok = blockmaplump[i] >= -1 && blockmaplump[i] < numlines;
+    }
+
+    if (!ok)
+    {
+        Z_Free(blockmaplump);
+        return false;
+    }
+
+    bmaporgx = blockmaplump[0];
+    bmaporgy = blockmaplump[1];
+    bmapwidth = width;
+    bmapheight = height;
+    blockmaplump_size = count;
+
+    return true;
+}
+
+static parsecache_t build_cache;
+static boolean build_pending;
+
+static void CreateBlockMap(void)
+{
+    InitBlockMapCache(&build_cache);
+
+    if (ReadBlockMapCache(&build_cache))
+    {
+        I_Printf(VB_DEBUG, "P_LoadBlockMap: loaded blockmap from cache");
+        M_CloseParseCache(&build_cache, false);
+        return;
+    }
+
+    StartCreateBlockMap();
+    build_pending = true;
+}
+
+void P_FinishBlockMap(void)
+{
+    if (build_pending)
+    {
+        FinishCreateBlockMap();
+        build_pending = false;
+
+        MEMFILE *stream = M_WriteParseCache(&build_cache);
+
+        if (stream)
+        {
+            M_CacheWriteInt(stream, BLOCKMAP_CACHE_VERSION);
+            M_CacheWriteInt(stream, blockmaplump_size);
+
+            for (int i = 0; i < blockmaplump_size; i++)
+            {
+                M_CacheWriteInt(stream, blockmaplump[i]);
+            }
+        }
+
+        M_CloseParseCache(&build_cache, true);
+    }
+
+    blockmap = blockmaplump + 4;
+}
+
 // Check if there is at least one block in BLOCKMAP
 // which does not have 0 as the first item in the list
 
@@ -695,6 +998,7 @@ static void LoadBlockmap_DoomBlockmap(int lump, int bmap_size)
     short *wadblockmaplump = W_CacheLumpNum(lump, PU_STATIC);
     int count = bmap_size / sizeof(uint16_t);
     blockmaplump = Z_Malloc(sizeof(*blockmaplump) * count, PU_LEVEL, 0);
+    blockmaplump_size = count;
 
     // killough 3/1/98: Expand wad blockmap into larger internal one,
     // by treating all offsets except -1 as unsigned and zero-extending
@@ -727,6 +1031,7 @@ static void LoadBlockmap_XBM1(int lump, int bmap_size)
     int32_t *data = W_CacheLumpNum(lump, PU_STATIC);
     int count = (bmap_size - 8) / sizeof(uint32_t);
     blockmaplump = Z_Malloc(sizeof(*blockmaplump) * count, PU_LEVEL, 0);
+    blockmaplump_size = count;
 
     // skip prefix header
     // data[0] = "XBM1"
@@ -760,7 +1065,7 @@ bmap_format_t P_LoadBlockMap(int lump)
             LoadBlockmap_XBM1(lump, bmap_size);
             break;
         case BMAP_BoomBuilder:
-            P_CreateBlockMap();
+            CreateBlockMap();
             break;
     }
 
@@ -768,7 +1073,6 @@ bmap_format_t P_LoadBlockMap(int lump)
     blocklinks_size = sizeof(*blocklinks) * bmapwidth * bmapheight;
     blocklinks = M_ArenaAlloc(world_arena, blocklinks_size, alignof(mobj_t *));
     memset(blocklinks, 0, blocklinks_size);
-    blockmap = blockmaplump + 4;
 
     return format;
 }
@@ -88,41 +88,159 @@ static void P_NewChaseDir(mobj_t *actor);
 // sound blocking lines cut off traversal.
 //
 // killough 5/5/98: reformatted, cleaned up
+//
+// [Woof!] Uses an explicit stack, so that large maps can't overflow the
+// C stack, and visits the lines in the same order as the recursion did.
+// The sector across each line is looked up once per level.
+//
 
-static void P_RecursiveSound(sector_t *sec, int soundblocks,
-			     mobj_t *soundtarget)
+typedef struct
 {
-  int i;
+  line_t *line;
+  sector_t *other; // NULL for lines without a back side
+} soundedge_t;
+
+typedef struct
+{
+  sector_t *sec;
+  int soundblocks;
+  int next, end; // edges left to check
+} soundframe_t;
+
+static soundedge_t *sound_edges;
+static int *sound_first_edge;
+static soundframe_t *sound_stack;
+
+static void P_BuildSoundGraph(void)
+{
+  int count = 0;
+
+  for (int i = 0; i < numsectors; i++)
+    count += sectors[i].linecount;
+
+  Z_Malloc((numsectors + 1) * sizeof(*sound_first_edge), PU_LEVEL,
+           (void **)&sound_first_edge);
+  Z_Malloc(MAX(count, 1) * sizeof(*sound_edges), PU_LEVEL,
+           (void **)&sound_edges);
+
+  // A sector is entered at most twice per flood, the second time only if
+  // it can be reached without crossing a sound blocking line.
+  Z_Malloc((2 * numsectors + 1) * sizeof(*sound_stack), PU_LEVEL,
+           (void **)&sound_stack);
+
+  count = 0;
 
+  for (int i = 0; i < numsectors; i++)
+    {
+      const sector_t *sec = &sectors[i];
+
+      sound_first_edge[i] = count;
+
+      for (int j = 0; j < sec->linecount; j++)
+        {
+          line_t *check = sec->lines[j];
+          soundedge_t *edge = &sound_edges[count++];
+
+          edge->line = check;
+          edge->other = check->sidenum[1] == NO_INDEX ? NULL :
+            sides[check->sidenum[sides[check->sidenum[0]].sector==sec]].sector;
+        }
+    }
+
+  sound_first_edge[numsectors] = count;
+}
+
+static boolean P_EnterSoundSector(sector_t *sec, int soundblocks,
+                                  mobj_t *soundtarget)
+{
   // wake up all monsters in this sector
   if (sec->validcount == validcount && sec->soundtraversed <= soundblocks+1)
-    return;             // already flooded
+    return false;       // already flooded
 
   sec->validcount = validcount;
   sec->soundtraversed = soundblocks+1;
   P_SetTarget(&sec->soundtarget, soundtarget);     // killough 11/98
+  return true;
+}
 
-  for (i=0; i<sec->linecount; i++)
+static void P_PushSoundSector(int *top, sector_t *sec, int soundblocks)
+{
+  soundframe_t *frame = &sound_stack[(*top)++];
+  const int i = sec - sectors;
+
+  frame->sec = sec;
+  frame->soundblocks = soundblocks;
+  frame->next = sound_first_edge[i];
+  frame->end = sound_first_edge[i + 1];
+}
+
+static void P_RecursiveSound(sector_t *sec, int soundblocks,
+			     mobj_t *soundtarget)
+{
+  line_t *last_line = NULL, *last_opening = NULL;
+  int top = 0;
+
+  if (!sound_edges)
+    P_BuildSoundGraph();
+
+  if (!P_EnterSoundSector(sec, soundblocks, soundtarget))
+    return;
+
+  P_PushSoundSector(&top, sec, soundblocks);
+
+  while (top > 0)
     {
-      sector_t *other;
-      line_t *check = sec->lines[i];
+      soundframe_t *frame = &sound_stack[top - 1];
+      const soundedge_t *edge;
+      line_t *check;
+      fixed_t ceilingz, floorz;
+
+      if (frame->next == frame->end)
+        {
+          top--;
+          continue;
+        }
+
+      edge = &sound_edges[frame->next++];
+      check = edge->line;
 
       if (!(check->flags & ML_TWOSIDED))
         continue;
 
-      P_LineOpening(check);
+      last_line = check;
 
-      if (openrange <= 0)
-        continue;       // closed door
+      if (!edge->other)
+        continue;       // no back side, P_LineOpening() reports it closed
 
-      other=sides[check->sidenum[sides[check->sidenum[0]].sector==sec]].sector;
+      last_opening = check;
+
+      // same as P_LineOpening(), without touching the globals
+      ceilingz = MIN(check->frontsector->ceilingheight,
+                     check->backsector->ceilingheight);
+      floorz = MAX(check->frontsector->floorheight,
+                   check->backsector->floorheight);
+
+      if (ceilingz - floorz <= 0)
+        continue;       // closed door
 
       if (!(check->flags & ML_SOUNDBLOCK))
-        P_RecursiveSound(other, soundblocks, soundtarget);
+        {
+          if (P_EnterSoundSector(edge->other, frame->soundblocks, soundtarget))
+            P_PushSoundSector(&top, edge->other, frame->soundblocks);
+        }
       else
-        if (!soundblocks)
-          P_RecursiveSound(other, 1, soundtarget);
+        if (!frame->soundblocks)
+          {
+            if (P_EnterSoundSector(edge->other, 1, soundtarget))
+              P_PushSoundSector(&top, edge->other, 1);
+          }
     }
+
+  // Leave the line opening globals as the recursion did.
+  if (last_opening)
+    P_LineOpening(last_opening);
+  if (last_line != last_opening)
+    P_LineOpening(last_line);
 }
 
 //
@@ -619,11 +737,13 @@ static fixed_t dropoff_deltax, dropoff_deltay, floorz;
 
 static boolean PIT_AvoidDropoff(line_t *line)
 {
+  const fixed_t *bbox = lineboxes[line - lines].bbox;
+
   if (line->backsector                          && // Ignore one-sided linedefs
-      tmbbox[BOXRIGHT]  > line->bbox[BOXLEFT]   &&
-      tmbbox[BOXLEFT]   < line->bbox[BOXRIGHT]  &&
-      tmbbox[BOXTOP]    > line->bbox[BOXBOTTOM] && // Linedef must be contacted
-      tmbbox[BOXBOTTOM] < line->bbox[BOXTOP]    &&
+      tmbbox[BOXRIGHT]  > bbox[BOXLEFT]   &&
+      tmbbox[BOXLEFT]   < bbox[BOXRIGHT]  &&
+      tmbbox[BOXTOP]    > bbox[BOXBOTTOM] && // Linedef must be contacted
+      tmbbox[BOXBOTTOM] < bbox[BOXTOP]    &&
       P_BoxOnLineSide(tmbbox, line) == -1)
     {
       fixed_t front = line->frontsector->floorheight;
@@ -1738,7 +1858,7 @@ static boolean P_HealCorpse(mobj_t* actor, int radius, statenum_t healstate, sfx
               // Call PIT_VileCheck to check
               // whether object is a corpse
               // that canbe raised.
-              if (!P_BlockThingsIterator(bx, by, PIT_VileCheck, true))
+              if (!P_BlockCorpsesIterator(bx, by, PIT_VileCheck, true))
                 {
 		  mobjinfo_t *info;
 
@@ -1766,6 +1886,7 @@ static boolean P_HealCorpse(mobj_t* actor, int radius, statenum_t healstate, sfx
 		  // friendliness is transferred from AV to raised corpse
 		  corpsehit->flags = 
 		    (info->flags & ~MF_FRIEND) | (actor->flags & MF_FRIEND);
+		  P_UpdateCorpseIndex(corpsehit);
 
 		  WatchResurrection(corpsehit, actor);
 
@@ -2090,9 +2211,9 @@ void A_PainShootSkull(mobj_t *actor, angle_t angle)
       // count total number of skulls currently on the level
       int count = 20;
       thinker_t *currentthinker;
-      for (currentthinker = thinkercap.next;
-           currentthinker != &thinkercap;
-           currentthinker = currentthinker->next)
+      for (currentthinker = thinkerkindcap[tk_mobj].knext;
+           currentthinker != &thinkerkindcap[tk_mobj];
+           currentthinker = currentthinker->knext)
         if ((currentthinker->function.p1 == P_MobjThinker)
             && ((mobj_t *)currentthinker)->type == MT_SKULL)
 	  if (--count < 0)         // killough 8/29/98: early exit
@@ -2334,7 +2455,8 @@ void A_BossDeath(mobj_t *mo)
 
       // scan the remaining thinkers to see
       // if all bosses are dead
-      for (th = thinkercap.next; th != &thinkercap; th = th->next)
+      for (th = thinkerkindcap[tk_mobj].knext; th != &thinkerkindcap[tk_mobj];
+           th = th->knext)
       {
           if (th->function.p1 == P_MobjThinker)
           {
@@ -2449,7 +2571,8 @@ void A_BossDeath(mobj_t *mo)
 
   // scan the remaining thinkers to see
   // if all bosses are dead
-  for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+  for (th = thinkerkindcap[tk_mobj].knext ; th != &thinkerkindcap[tk_mobj] ;
+       th=th->knext)
     if (th->function.p1 == P_MobjThinker)
       {
         mobj_t *mo2 = (mobj_t *) th;
@@ -2560,7 +2683,8 @@ void P_SpawnBrainTargets(void)  // killough 3/26/98: renamed old function
   brain.targeton = 0;
   brain.easy = 0;           // killough 3/26/98: always init easy to 0
 
-  for (thinker=thinkercap.next; thinker != &thinkercap; thinker=thinker->next)
+  for (thinker = thinkerkindcap[tk_mobj].knext;
+       thinker != &thinkerkindcap[tk_mobj]; thinker = thinker->knext)
     if (thinker->function.p1 == P_MobjThinker)
       {
         mobj_t *m = (mobj_t *) thinker;
@@ -2759,7 +2883,8 @@ void A_KeenDie(mobj_t* mo)
 
   // scan the remaining thinkers to see if all Keens are dead
 
-  for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+  for (th = thinkerkindcap[tk_mobj].knext ; th != &thinkerkindcap[tk_mobj] ;
+       th=th->knext)
     if (th->function.p1 == P_MobjThinker)
       {
         mobj_t *mo2 = (mobj_t *) th;
@@ -3321,6 +3446,7 @@ void A_AddFlags(mobj_t* actor)
 
   actor->flags  |= flags;
   actor->flags2 |= flags2;
+  P_UpdateCorpseIndex(actor);
 
   if (update_blockmap)
     P_SetThingPosition(actor);
@@ -3353,6 +3479,7 @@ void A_RemoveFlags(mobj_t* actor)
 
   actor->flags  &= ~flags;
   actor->flags2 &= ~flags2;
+  P_UpdateCorpseIndex(actor);
 
   if (update_blockmap)
     P_SetThingPosition(actor);
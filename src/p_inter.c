@@ -31,6 +31,7 @@
 #include "info.h"
 #include "m_fixed.h"
 #include "m_random.h"
+#include "p_maputl.h"
 #include "p_mobj.h"
 #include "p_pspr.h"
 #include "p_tick.h"
@@ -658,6 +659,7 @@ static void P_KillMobj(mobj_t *source, mobj_t *inflictor, mobj_t *target, method
     target->flags &= ~MF_NOGRAVITY;
 
   target->flags |= MF_CORPSE|MF_DROPOFF;
+  P_UpdateCorpseIndex(target);
   target->height >>= 2;
 
   // killough 8/29/98: remove from threaded list
@@ -165,6 +165,38 @@ void T_GlowAdapter(mobj_t *mobj)
     T_Glow((glow_t *)mobj);
 }
 
+// [Woof!] Runs consecutive light thinkers of any type, see P_RunThinkers().
+
+void T_RunLightBatch(thinker_t *const *thinkers, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        thinker_t *thinker = thinkers[i];
+        const actionf_p1 function = thinker->function.p1;
+
+        if (function == T_FireFlickerAdapter)
+        {
+            T_FireFlicker((fireflicker_t *)thinker);
+        }
+        else if (function == T_LightFlashAdapter)
+        {
+            T_LightFlash((lightflash_t *)thinker);
+        }
+        else if (function == T_StrobeFlashAdapter)
+        {
+            T_StrobeFlash((strobe_t *)thinker);
+        }
+        else if (function == T_GlowAdapter)
+        {
+            T_Glow((glow_t *)thinker);
+        }
+        else if (function)
+        {
+            function((mobj_t *)thinker);
+        }
+    }
+}
+
 //////////////////////////////////////////////////////////
 //
 // Sector lighting type spawners
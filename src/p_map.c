@@ -18,7 +18,9 @@
 //
 //-----------------------------------------------------------------------------
 
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "d_player.h"
 #include "deh_misc.h"
@@ -39,8 +41,10 @@
 #include "p_map.h"
 #include "p_maputl.h"
 #include "p_mobj.h"
+#include "p_reject.h"
 #include "p_setup.h"
 #include "p_spec.h"
+#include "p_tick.h"
 #include "p_user.h"
 #include "r_defs.h"
 #include "r_main.h"
@@ -95,6 +99,20 @@ int numspechit;
 // Temporary holder for thing_sectorlist threads
 msecnode_t *sector_list = NULL;                             // phares 3/16/98
 
+// [Woof!] Margin around an object's box in which P_CreateSecNodeList looks
+// for lines, so that later calls can skip the blockmap while the object
+// stays clear of them.
+#define SECNODE_MARGIN (16 * FRACUNIT)
+
+static fixed_t safebox[4];
+static boolean safeboxclear;
+
+static struct
+{
+  int calls;   // calls to P_CreateSecNodeList()
+  int skipped; // answered by the object's safe box
+} secnodestats;
+
 arena_t *msecnodes_arena;
 
 //
@@ -348,12 +366,14 @@ boolean P_TeleportMove(mobj_t *thing, fixed_t x, fixed_t y, boolean boss)
 
 static boolean PIT_CrossLine(line_t *ld)
 {
+  const fixed_t *bbox = lineboxes[ld - lines].bbox;
+
   return 
     !((ld->flags ^ ML_TWOSIDED) & (ML_TWOSIDED|ML_BLOCKING|ML_BLOCKMONSTERS))
-    || tmbbox[BOXLEFT]   > ld->bbox[BOXRIGHT]
-    || tmbbox[BOXRIGHT]  < ld->bbox[BOXLEFT]   
-    || tmbbox[BOXTOP]    < ld->bbox[BOXBOTTOM]
-    || tmbbox[BOXBOTTOM] > ld->bbox[BOXTOP]
+    || tmbbox[BOXLEFT]   > bbox[BOXRIGHT]
+    || tmbbox[BOXRIGHT]  < bbox[BOXLEFT]   
+    || tmbbox[BOXTOP]    < bbox[BOXBOTTOM]
+    || tmbbox[BOXBOTTOM] > bbox[BOXTOP]
     || P_PointOnLineSide(pe_x,pe_y,ld) == P_PointOnLineSide(ls_x,ls_y,ld);
 }
 
@@ -363,11 +383,12 @@ static boolean PIT_CrossLine(line_t *ld)
 static int untouched(line_t *ld)
 {
   fixed_t x, y, tmbbox[4];
+  const fixed_t *bbox = lineboxes[ld - lines].bbox;
   return 
-    (tmbbox[BOXRIGHT] = (x=tmthing->x)+tmthing->radius) <= ld->bbox[BOXLEFT] ||
-    (tmbbox[BOXLEFT] = x-tmthing->radius) >= ld->bbox[BOXRIGHT] ||
-    (tmbbox[BOXTOP] = (y=tmthing->y)+tmthing->radius) <= ld->bbox[BOXBOTTOM] ||
-    (tmbbox[BOXBOTTOM] = y-tmthing->radius) >= ld->bbox[BOXTOP] ||
+    (tmbbox[BOXRIGHT] = (x=tmthing->x)+tmthing->radius) <= bbox[BOXLEFT] ||
+    (tmbbox[BOXLEFT] = x-tmthing->radius) >= bbox[BOXRIGHT] ||
+    (tmbbox[BOXTOP] = (y=tmthing->y)+tmthing->radius) <= bbox[BOXBOTTOM] ||
+    (tmbbox[BOXBOTTOM] = y-tmthing->radius) >= bbox[BOXTOP] ||
     P_BoxOnLineSide(tmbbox, ld) != -1;
 }
 
@@ -384,10 +405,13 @@ static void SpechitOverrun(line_t *ld);
 
 static boolean PIT_CheckLine(line_t *ld) // killough 3/26/98: make static
 {
-  if (tmbbox[BOXRIGHT] <= ld->bbox[BOXLEFT]
-      || tmbbox[BOXLEFT] >= ld->bbox[BOXRIGHT]
-      || tmbbox[BOXTOP] <= ld->bbox[BOXBOTTOM]
-      || tmbbox[BOXBOTTOM] >= ld->bbox[BOXTOP] )
+  // [Woof!] read the packed bounding box, most lines are rejected here
+  const fixed_t *bbox = lineboxes[ld - lines].bbox;
+
+  if (tmbbox[BOXRIGHT] <= bbox[BOXLEFT]
+      || tmbbox[BOXLEFT] >= bbox[BOXRIGHT]
+      || tmbbox[BOXTOP] <= bbox[BOXBOTTOM]
+      || tmbbox[BOXBOTTOM] >= bbox[BOXTOP] )
     return true; // didn't hit it
 
   if (P_BoxOnLineSide(tmbbox, ld) != -1)
@@ -968,12 +992,14 @@ boolean P_TryMove(mobj_t *thing, fixed_t x, fixed_t y, int dropoff)
 
 static boolean PIT_ApplyTorque(line_t *ld)
 {
+  const fixed_t *bbox = lineboxes[ld - lines].bbox;
+
   if (ld->backsector &&       // If thing touches two-sided pivot linedef
       (ld->dx || ld->dy) && // Torque is undefined if the line has no length
-      tmbbox[BOXRIGHT]  > ld->bbox[BOXLEFT]  &&
-      tmbbox[BOXLEFT]   < ld->bbox[BOXRIGHT] &&
-      tmbbox[BOXTOP]    > ld->bbox[BOXBOTTOM] &&
-      tmbbox[BOXBOTTOM] < ld->bbox[BOXTOP] &&
+      tmbbox[BOXRIGHT]  > bbox[BOXLEFT]  &&
+      tmbbox[BOXLEFT]   < bbox[BOXRIGHT] &&
+      tmbbox[BOXTOP]    > bbox[BOXBOTTOM] &&
+      tmbbox[BOXBOTTOM] < bbox[BOXTOP] &&
       P_BoxOnLineSide(tmbbox, ld) == -1)
     {
       mobj_t *mo = tmthing;
@@ -1903,11 +1929,16 @@ boolean P_CheckSight_12(mobj_t *t1, mobj_t *t2)
   bytenum = pnum>>3;
   bitnum = 1 << (pnum&7);
 
+  sightstats.checks++;
+
   if (rejectmatrix[bytenum]&bitnum)
   {
+    sightstats.rejected++;
     return false;    // can't possibly be connected
   }
 
+  sightstats.traversals++;
+
   //
   // check precisely
   //
@@ -2316,10 +2347,22 @@ void P_DelSeclist(msecnode_t *node)
 
 static boolean PIT_GetSectors(line_t *ld)
 {
-  if (tmbbox[BOXRIGHT]  <= ld->bbox[BOXLEFT]   ||
-      tmbbox[BOXLEFT]   >= ld->bbox[BOXRIGHT]  ||
-      tmbbox[BOXTOP]    <= ld->bbox[BOXBOTTOM] ||
-      tmbbox[BOXBOTTOM] >= ld->bbox[BOXTOP])
+  const fixed_t *bbox = lineboxes[ld - lines].bbox;
+
+  // [Woof!] The safe box contains tmbbox, so every line that crosses
+  // tmbbox also clears it here.
+  if (safeboxclear &&
+      safebox[BOXRIGHT]  > bbox[BOXLEFT]   &&
+      safebox[BOXLEFT]   < bbox[BOXRIGHT]  &&
+      safebox[BOXTOP]    > bbox[BOXBOTTOM] &&
+      safebox[BOXBOTTOM] < bbox[BOXTOP]    &&
+      P_BoxOnLineSide(safebox, ld) == -1)
+    safeboxclear = false;
+
+  if (tmbbox[BOXRIGHT]  <= bbox[BOXLEFT]   ||
+      tmbbox[BOXLEFT]   >= bbox[BOXRIGHT]  ||
+      tmbbox[BOXTOP]    <= bbox[BOXBOTTOM] ||
+      tmbbox[BOXBOTTOM] >= bbox[BOXTOP])
     return true;
 
   if (P_BoxOnLineSide(tmbbox, ld) != -1)
@@ -2366,14 +2409,6 @@ void P_CreateSecNodeList(mobj_t *thing,fixed_t x,fixed_t y)
   int saved_tmflags = tmflags;
   fixed_t saved_tmx = tmx, saved_tmy = tmy;
 
-  // First, clear out the existing m_thing fields. As each node is
-  // added or verified as needed, m_thing will be set properly. When
-  // finished, delete all nodes where m_thing is still NULL. These
-  // represent the sectors the Thing has vacated.
-  
-  for (node = sector_list; node; node = node->m_tnext)
-    node->m_thing = NULL;
-
   tmthing = thing;
   tmflags = thing->flags;
 
@@ -2385,33 +2420,88 @@ void P_CreateSecNodeList(mobj_t *thing,fixed_t x,fixed_t y)
   tmbbox[BOXRIGHT]  = x + tmthing->radius;
   tmbbox[BOXLEFT]   = x - tmthing->radius;
 
-  validcount++; // used to make sure we only process a line once
-
-  xl = (tmbbox[BOXLEFT] - bmaporgx)>>MAPBLOCKSHIFT;
-  xh = (tmbbox[BOXRIGHT] - bmaporgx)>>MAPBLOCKSHIFT;
-  yl = (tmbbox[BOXBOTTOM] - bmaporgy)>>MAPBLOCKSHIFT;
-  yh = (tmbbox[BOXTOP] - bmaporgy)>>MAPBLOCKSHIFT;
-
-  for (bx=xl ; bx<=xh ; bx++)
-    for (by=yl ; by<=yh ; by++)
-      P_BlockLinesIterator(bx,by,PIT_GetSectors);
-
-  // Add the sector of the (x,y) point to sector_list.
+  secnodestats.calls++;
+
+  // [Woof!] The last call found no line crossing the safe box, and the
+  // object only touched the sector it is in. If its box is still within
+  // the safe box, the same blockmap cells or fewer would be searched, no
+  // line would cross the box and the list would stay as it is. Its only
+  // node still belongs to the object, since m_thing is not cleared then.
+
+  if (thing->secnodesafe &&
+      tmbbox[BOXLEFT]   >= thing->secnodebox[BOXLEFT]   &&
+      tmbbox[BOXRIGHT]  <= thing->secnodebox[BOXRIGHT]  &&
+      tmbbox[BOXBOTTOM] >= thing->secnodebox[BOXBOTTOM] &&
+      tmbbox[BOXTOP]    <= thing->secnodebox[BOXTOP]    &&
+      sector_list && !sector_list->m_tnext &&
+      sector_list->m_sector == thing->subsector->sector &&
+      sector_list->m_thing == thing)
+    {
+      secnodestats.skipped++;
+    }
+  else
+    {
+      // First, clear out the existing m_thing fields. As each node is
+      // added or verified as needed, m_thing will be set properly. When
+      // finished, delete all nodes where m_thing is still NULL. These
+      // represent the sectors the Thing has vacated.
+
+      for (node = sector_list; node; node = node->m_tnext)
+        node->m_thing = NULL;
+
+      validcount++; // used to make sure we only process a line once
+
+      xl = (tmbbox[BOXLEFT] - bmaporgx)>>MAPBLOCKSHIFT;
+      xh = (tmbbox[BOXRIGHT] - bmaporgx)>>MAPBLOCKSHIFT;
+      yl = (tmbbox[BOXBOTTOM] - bmaporgy)>>MAPBLOCKSHIFT;
+      yh = (tmbbox[BOXTOP] - bmaporgy)>>MAPBLOCKSHIFT;
+
+      // [Woof!] Grow the box by the margin, but only as far as the blockmap
+      // cells that are searched anyway. The edges are computed in 64 bits,
+      // the cells of large blockmaps reach beyond the range of fixed_t.
+
+      safebox[BOXLEFT]   = MAX((int64_t)tmbbox[BOXLEFT] - SECNODE_MARGIN,
+                               MAX(bmaporgx + (int64_t)xl * MAPBLOCKSIZE,
+                                   INT_MIN));
+      safebox[BOXRIGHT]  = MIN((int64_t)tmbbox[BOXRIGHT] + SECNODE_MARGIN,
+                               MIN(bmaporgx + (int64_t)(xh + 1) * MAPBLOCKSIZE - 1,
+                                   INT_MAX));
+      safebox[BOXBOTTOM] = MAX((int64_t)tmbbox[BOXBOTTOM] - SECNODE_MARGIN,
+                               MAX(bmaporgy + (int64_t)yl * MAPBLOCKSIZE,
+                                   INT_MIN));
+      safebox[BOXTOP]    = MIN((int64_t)tmbbox[BOXTOP] + SECNODE_MARGIN,
+                               MIN(bmaporgy + (int64_t)(yh + 1) * MAPBLOCKSIZE - 1,
+                                   INT_MAX));
+      safeboxclear = true;
+
+      for (bx=xl ; bx<=xh ; bx++)
+        for (by=yl ; by<=yh ; by++)
+          P_BlockLinesIterator(bx,by,PIT_GetSectors);
+
+      // Add the sector of the (x,y) point to sector_list.
+
+      sector_list = P_AddSecnode(thing->subsector->sector,thing,sector_list);
+
+      // Now delete any nodes that won't be used. These are the ones where
+      // m_thing is still NULL.
+
+      for (node = sector_list; node;)
+        if (node->m_thing == NULL)
+          {
+            if (node == sector_list)
+              sector_list = node->m_tnext;
+            node = P_DelSecnode(node);
+          }
+        else
+          node = node->m_tnext;
 
-  sector_list = P_AddSecnode(thing->subsector->sector,thing,sector_list);
+      // [Woof!] If no line crossed the safe box, none crossed the object's
+      // box either, and the list holds just the sector it is in.
 
-  // Now delete any nodes that won't be used. These are the ones where
-  // m_thing is still NULL.
-  
-  for (node = sector_list; node;)
-    if (node->m_thing == NULL)
-      {
-	if (node == sector_list)
-	  sector_list = node->m_tnext;
-	node = P_DelSecnode(node);
-      }
-    else
-      node = node->m_tnext;
+      thing->secnodesafe = safeboxclear;
+      if (safeboxclear)
+        memcpy(thing->secnodebox, safebox, sizeof(safebox));
+    }
 
   // [FG] Overlapping uses of global variables in p_map.c
   // http://prboom.sourceforge.net/mbf-bugs.html
@@ -2434,6 +2524,30 @@ void P_CreateSecNodeList(mobj_t *thing,fixed_t x,fixed_t y)
    }
 }
 
+// [Woof!] Called before the level is freed.
+
+void P_ReportSecNodeStats(void)
+{
+  if (secnodestats.calls)
+    I_Printf(VB_DEBUG, "P_CreateSecNodeList: %d calls, %d skipped.",
+             secnodestats.calls, secnodestats.skipped);
+
+  memset(&secnodestats, 0, sizeof(secnodestats));
+}
+
+// [Woof!] Called after mobjs have been restored in place, their safe boxes
+// may not match the restored sector lists.
+
+void P_ResetSecNodeBoxes(void)
+{
+  thinker_t *th;
+
+  for (th = thinkerkindcap[tk_mobj].knext; th != &thinkerkindcap[tk_mobj];
+       th = th->knext)
+    if (th->function.p1 == P_MobjThinker)
+      ((mobj_t *) th)->secnodesafe = false;
+}
+
 /* cphipps 2004/08/30 -
  * Must clear tmthing at tic end, as it might contain a pointer to a
  * removed thinker, or the level might have ended/been ended and we
@@ -50,6 +50,7 @@ boolean P_TryMove(struct mobj_s *thing, fixed_t x, fixed_t y, int dropoff);
 boolean P_TeleportMove(struct mobj_s *thing, fixed_t x, fixed_t y, boolean boss);
 void    P_SlideMove(struct mobj_s *mo);
 extern boolean (*P_CheckSight)(struct mobj_s *t1, struct mobj_s *t2);
+void    P_InvalidateSightCache(void); // [Woof!] on plane moves and every tic
 boolean P_CheckFov(struct mobj_s *t1, struct mobj_s *t2, angle_t fov);
 void    P_UseLines(struct player_s *player);
 
@@ -66,6 +67,8 @@ boolean P_ChangeSector(struct sector_s *sector,boolean crunch);
 //jff 3/19/98 P_CheckSector(): new routine to replace P_ChangeSector()
 boolean P_CheckSector(struct sector_s *sector, boolean crunch);
 void    P_DelSeclist(struct msecnode_s *);                          // phares 3/16/98
+void    P_ReportSecNodeStats(void);                         // [Woof!]
+void    P_ResetSecNodeBoxes(void);                          // [Woof!]
 void    P_CreateSecNodeList(struct mobj_s *, fixed_t, fixed_t);       // phares 3/14/98
 boolean Check_Sides(struct mobj_s *, int, int);                    // phares
 
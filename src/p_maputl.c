@@ -22,15 +22,20 @@
 
 #include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "doomdata.h"
 #include "doomstat.h"
 #include "i_printf.h"
+#include "i_timer.h"
+#include "m_argv.h"
+#include "m_array.h"
 #include "m_bbox.h"
 #include "p_map.h"
 #include "p_maputl.h"
 #include "p_mobj.h"
 #include "p_setup.h"
+#include "p_tick.h"
 #include "r_defs.h"
 #include "r_main.h"
 #include "r_state.h"
@@ -83,28 +88,70 @@ int P_PointOnLineSide_Precise(fixed_t x, fixed_t y, line_t *line)
 //
 // killough 5/3/98: reformatted, cleaned up
 
+// [Woof!] Same as P_PointOnLineSide() for sloped lines, on the packed copy.
+
+static int PointOnSlopedLineSide(fixed_t x, fixed_t y, const linebox_t *lb)
+{
+  if (P_PointOnLineSide == P_PointOnLineSide_Precise)
+    return ((int64_t) y - lb->y) * lb->dx >= ((int64_t) x - lb->x) * lb->dy;
+
+  return
+    FixedMul(y-lb->y, lb->dx>>FRACBITS) >= FixedMul(lb->dy>>FRACBITS, x-lb->x);
+}
+
 int P_BoxOnLineSide(fixed_t *tmbox, line_t *ld)
 {
-  switch (ld->slopetype)
+  const linebox_t *lb = &lineboxes[ld - lines];
+
+  switch (lb->slopetype)
     {
       int p;
     default: // shut up compiler warnings -- killough
     case ST_HORIZONTAL:
       return
-      (tmbox[BOXBOTTOM] > ld->v1->y) == (p = tmbox[BOXTOP] > ld->v1->y) ?
-        p ^ (ld->dx < 0) : -1;
+      (tmbox[BOXBOTTOM] > lb->y) == (p = tmbox[BOXTOP] > lb->y) ?
+        p ^ (lb->dx < 0) : -1;
     case ST_VERTICAL:
       return
-        (tmbox[BOXLEFT] < ld->v1->x) == (p = tmbox[BOXRIGHT] < ld->v1->x) ?
-        p ^ (ld->dy < 0) : -1;
+        (tmbox[BOXLEFT] < lb->x) == (p = tmbox[BOXRIGHT] < lb->x) ?
+        p ^ (lb->dy < 0) : -1;
     case ST_POSITIVE:
       return
-        P_PointOnLineSide(tmbox[BOXRIGHT], tmbox[BOXBOTTOM], ld) ==
-        (p = P_PointOnLineSide(tmbox[BOXLEFT], tmbox[BOXTOP], ld)) ? p : -1;
+        PointOnSlopedLineSide(tmbox[BOXRIGHT], tmbox[BOXBOTTOM], lb) ==
+        (p = PointOnSlopedLineSide(tmbox[BOXLEFT], tmbox[BOXTOP], lb)) ? p : -1;
     case ST_NEGATIVE:
       return
-        (P_PointOnLineSide(tmbox[BOXLEFT], tmbox[BOXBOTTOM], ld)) ==
-        (p = P_PointOnLineSide(tmbox[BOXRIGHT], tmbox[BOXTOP], ld)) ? p : -1;
+        (PointOnSlopedLineSide(tmbox[BOXLEFT], tmbox[BOXBOTTOM], lb)) ==
+        (p = PointOnSlopedLineSide(tmbox[BOXRIGHT], tmbox[BOXTOP], lb)) ? p : -1;
+    }
+}
+
+//
+// P_InitLineBoxes
+//
+// [Woof!] The line geometry doesn't change during the level, so the copy
+// only needs to be made once all lines are loaded and P_RemoveSlimeTrails()
+// has moved their vertexes.
+//
+
+void P_InitLineBoxes(void)
+{
+  if (lineboxes)
+    free(lineboxes);
+
+  lineboxes = malloc(numlines * sizeof(*lineboxes));
+
+  for (int i = 0; i < numlines; i++)
+    {
+      const line_t *ld = &lines[i];
+      linebox_t *lb = &lineboxes[i];
+
+      memcpy(lb->bbox, ld->bbox, sizeof(lb->bbox));
+      lb->x = ld->v1->x;
+      lb->y = ld->v1->y;
+      lb->dx = ld->dx;
+      lb->dy = ld->dy;
+      lb->slopetype = ld->slopetype;
     }
 }
 
@@ -225,6 +272,80 @@ void P_LineOpening(line_t *linedef)
 // THING POSITION SETTING
 //
 
+//
+// [Woof!] Corpse index
+//
+// Number of MF_CORPSE things linked into each blockmap cell. Arch-viles
+// skip cells without any, and iterate all other cells in the usual order,
+// so the search finds the same corpse as before. The counts are rebuilt
+// from the blockmap after a level has been loaded or restored.
+//
+
+static int *corpse_counts;
+
+static void AddCorpse(mobj_t *thing)
+{
+  if (corpse_counts && thing->blockcell && !thing->corpsecell
+      && (thing->flags & MF_CORPSE))
+    {
+      corpse_counts[thing->blockcell - 1]++;
+      thing->corpsecell = thing->blockcell;
+    }
+}
+
+static void RemoveCorpse(mobj_t *thing)
+{
+  if (thing->corpsecell)
+    {
+      if (corpse_counts)
+        corpse_counts[thing->corpsecell - 1]--;
+      thing->corpsecell = 0;
+    }
+}
+
+static void RebuildCorpseIndex(void)
+{
+  const int count = bmapwidth * bmapheight;
+
+  Z_Malloc(count * sizeof(*corpse_counts), PU_LEVEL, (void **)&corpse_counts);
+  memset(corpse_counts, 0, count * sizeof(*corpse_counts));
+
+  for (thinker_t *th = thinkerkindcap[tk_mobj].knext;
+       th != &thinkerkindcap[tk_mobj]; th = th->knext)
+    {
+      if (th->function.p1 == P_MobjThinker)
+        {
+          mobj_t *mo = (mobj_t *)th;
+          mo->blockcell = mo->corpsecell = 0;
+        }
+    }
+
+  for (int i = 0; i < count; i++)
+    {
+      for (mobj_t *mo = blocklinks[i]; mo; mo = mo->bnext)
+        {
+          mo->blockcell = i + 1;
+          AddCorpse(mo);
+        }
+    }
+}
+
+void P_InvalidateCorpseIndex(void)
+{
+  if (corpse_counts)
+    Z_Free(corpse_counts);
+}
+
+// Call after changing the MF_CORPSE flag of a thing in the blockmap.
+void P_UpdateCorpseIndex(mobj_t *thing)
+{
+  if (thing->flags & MF_CORPSE)
+    AddCorpse(thing);
+  else
+    RemoveCorpse(thing);
+}
+
+
 //
 // P_UnsetThingPosition
 // Unlinks a thing from block map and sectors.
@@ -279,6 +400,9 @@ void P_UnsetThingPosition (mobj_t *thing)
       mobj_t *bnext, **bprev = thing->bprev;
       if (bprev && (*bprev = bnext = thing->bnext))  // unlink from block map
 	bnext->bprev = bprev;
+
+      RemoveCorpse(thing);
+      thing->blockcell = 0;
     }
 
     if (thing->type == MT_TELEPORTMAN)
@@ -349,6 +473,9 @@ void P_SetThingPosition(mobj_t *thing)
 	    bnext->bprev = &thing->bnext;
 	  thing->bprev = link;
           *link = thing;
+
+          thing->blockcell = blocky*bmapwidth+blockx + 1;
+          AddCorpse(thing);
         }
       else        // thing is off the map
         thing->bnext = NULL, thing->bprev = NULL;
@@ -571,6 +698,31 @@ boolean P_BlockThingsIterator(int x, int y, boolean func(mobj_t*),
   return true;
 }
 
+//
+// P_BlockCorpsesIterator
+// Same as P_BlockThingsIterator(), but skips cells that can't contain a
+// corpse. With the blockmap fix, the surrounding cells are checked, too.
+//
+
+boolean P_BlockCorpsesIterator(int x, int y, boolean func(mobj_t*),
+                               boolean do_blockmapfix)
+{
+  const int range = (CRITICAL(blockmapfix) && do_blockmapfix) ? 1 : 0;
+
+  if (x < 0 || y < 0 || x >= bmapwidth || y >= bmapheight)
+    return true;
+
+  if (!corpse_counts)
+    RebuildCorpseIndex();
+
+  for (int by = MAX(y - range, 0); by <= MIN(y + range, bmapheight - 1); by++)
+    for (int bx = MAX(x - range, 0); bx <= MIN(x + range, bmapwidth - 1); bx++)
+      if (corpse_counts[by*bmapwidth+bx])
+        return P_BlockThingsIterator(x, y, func, do_blockmapfix);
+
+  return true;
+}
+
 //
 // INTERCEPT ROUTINES
 //
@@ -712,10 +864,10 @@ boolean PIT_AddThingIntercepts(mobj_t *thing)
 //
 // killough 5/3/98: reformatted, cleaned up
 
-boolean P_TraverseIntercepts(traverser_t func, fixed_t maxfrac)
+static boolean TraverseInterceptsScan(traverser_t func, fixed_t maxfrac,
+                                      int count)
 {
   intercept_t *in = NULL;
-  int count = intercept_p - intercepts;
   while (count--)
     {
       fixed_t dist = INT_MAX;
@@ -732,6 +884,88 @@ boolean P_TraverseIntercepts(traverser_t func, fixed_t maxfrac)
   return true;                  // everything was traversed
 }
 
+// [Woof!] The scan above visits the intercepts in the order of their frac
+// and, for equal fracs, of their index. A binary heap with the same order
+// visits them identically in O(n log n). Traversers may start a nested
+// traversal, e.g. through a pain state action that fires a hitscan, which
+// refills the intercepts. The scan is resumed on the refilled intercepts
+// then, like before.
+
+#define HEAP_THRESHOLD 24
+
+static int *intercept_heap;
+static int intercept_heap_size;
+static int intercepts_epoch;
+static boolean scan_intercepts; // for the benchmark
+
+inline static boolean InterceptBefore(int a, int b)
+{
+  return intercepts[a].frac < intercepts[b].frac
+         || (intercepts[a].frac == intercepts[b].frac && a < b);
+}
+
+static void SiftDown(int *heap, int size, int i)
+{
+  const int item = heap[i];
+
+  for (;;)
+    {
+      int child = 2 * i + 1;
+      if (child >= size)
+        break;
+      if (child + 1 < size && InterceptBefore(heap[child + 1], heap[child]))
+        child++;
+      if (!InterceptBefore(heap[child], item))
+        break;
+      heap[i] = heap[child];
+      i = child;
+    }
+
+  heap[i] = item;
+}
+
+boolean P_TraverseIntercepts(traverser_t func, fixed_t maxfrac)
+{
+  int count = intercept_p - intercepts;
+
+  // The scan calls the traverser with a stale intercept if only
+  // intercepts at INT_MAX are left within maxfrac.
+  if (count < HEAP_THRESHOLD || maxfrac == INT_MAX || scan_intercepts)
+    return TraverseInterceptsScan(func, maxfrac, count);
+
+  if (intercept_heap_size < count)
+    {
+      intercept_heap_size = num_intercepts;
+      intercept_heap = Z_Realloc(intercept_heap,
+                                 intercept_heap_size * sizeof(*intercept_heap),
+                                 PU_STATIC, 0);
+    }
+
+  int *heap = intercept_heap;
+  int size = count;
+  const int epoch = intercepts_epoch;
+
+  for (int i = 0; i < size; i++)
+    heap[i] = i;
+  for (int i = size / 2 - 1; i >= 0; i--)
+    SiftDown(heap, size, i);
+
+  while (count--)
+    {
+      intercept_t *in = &intercepts[heap[0]];
+      if (in->frac > maxfrac)
+        return true;    // checked everything in range
+      heap[0] = heap[--size];
+      SiftDown(heap, size, 0);
+      if (!func(in))
+        return false;           // don't bother going farther
+      in->frac = INT_MAX;
+      if (intercepts_epoch != epoch)
+        return TraverseInterceptsScan(func, maxfrac, count);
+    }
+  return true;                  // everything was traversed
+}
+
 // Intercepts Overrun emulation, from PrBoom-plus.
 // Thanks to Andrey Budko (entryway) for researching this and his 
 // implementation of Intercepts Overrun emulation in PrBoom-plus
@@ -878,6 +1112,7 @@ boolean P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2,
 
   validcount++;
   intercept_p = intercepts;
+  intercepts_epoch++;
 
   if (!((x1-bmaporgx)&(MAPBLOCKSIZE-1)))
     x1 += FRACUNIT;     // don't side exactly on a line
@@ -981,6 +1216,97 @@ boolean P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2,
   return P_TraverseIntercepts(trav, FRACUNIT);
 }
 
+//
+// P_InterceptBenchmark
+//
+// [Woof!] Times BFG sprays with the selection scan and with the heap. Like
+// A_BFGSpray(), every spray aims 40 tracers across a 90 degree cone with
+// P_AimLineAttack(), twice per tracer for MBF demos. The sprays are fired
+// from the places where the player and the monsters of the level stand,
+// facing their way, turning a bit with every round through them.
+//
+
+void P_InterceptBenchmark(void)
+{
+  //!
+  // @category obscure
+  // @arg <n>
+  //
+  // Fire n BFG sprays from the player and monster positions after loading a
+  // level, with the former and the current intercept traversal, and print
+  // the timings.
+  //
+
+  const int p = M_CheckParmWithArgs("-interceptbench", 1);
+
+  if (!p)
+    return;
+
+  mobj_t **shooters = NULL;
+  thinker_t *th;
+
+  for (th = thinkerkindcap[tk_mobj].knext; th != &thinkerkindcap[tk_mobj];
+       th = th->knext)
+    {
+      mobj_t *mo = (mobj_t *)th;
+
+      if (th->function.p1 == P_MobjThinker
+          && (mo->player || (mo->flags & MF_COUNTKILL)))
+        array_push(shooters, mo);
+    }
+
+  if (!array_size(shooters))
+    return;
+
+  const int sprays = MAX(1, M_ParmArgToInt(p));
+  const boolean overflow_enabled = overflow[emu_intercepts].enabled;
+  mobj_t *saved_linetarget = linetarget;
+  int hits = 0;
+  uint64_t time[2];
+
+  overflow[emu_intercepts].enabled = false;
+
+  for (int pass = 0; pass < 2; pass++)
+    {
+      const uint64_t start = I_GetTimeNS();
+
+      scan_intercepts = (pass == 0);
+      hits = 0;
+
+      for (int i = 0; i < sprays; i++)
+        {
+          mobj_t *mo = shooters[i % array_size(shooters)];
+          const angle_t base =
+            mo->angle + (angle_t)(i / array_size(shooters)) * (ANG1 * 7);
+
+          for (int j = 0; j < 40; j++)
+            {
+              const angle_t an = base - ANG90/2 + ANG90/40*j;
+
+              if (demo_version < DV_MBF ||
+                  (P_AimLineAttack(mo, an, 16*64*FRACUNIT, MF_FRIEND),
+                   !linetarget))
+                P_AimLineAttack(mo, an, 16*64*FRACUNIT, 0);
+
+              hits += (linetarget != NULL);
+            }
+        }
+
+      time[pass] = I_GetTimeNS() - start;
+    }
+
+  scan_intercepts = false;
+  overflow[emu_intercepts].enabled = overflow_enabled;
+  linetarget = saved_linetarget;
+
+  I_Printf(VB_ALWAYS, "P_InterceptBenchmark: %d sprays from %d positions, "
+           "%d hits, scan %.2f ms, heap %.2f ms", sprays,
+           array_size(shooters), hits, time[0] / 1000000.0,
+           time[1] / 1000000.0);
+
+  array_free(shooters);
+}
+
 //
 // mbf21: RoughBlockCheck
 // [XA] adapted from Hexen -- used by P_RoughTargetSearch
@@ -1278,6 +1604,7 @@ boolean P_SightPathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2)
 
   validcount++;
   intercept_p = intercepts;
+  intercepts_epoch++;
 
   if (((x1-bmaporgx)&(MAPBLOCKSIZE-1)) == 0)
     x1 += FRACUNIT;        // don't side exactly on a line
@@ -66,15 +66,21 @@ int     P_PointOnDivlineSide_Precise(fixed_t x, fixed_t y, divline_t *line);
 void    P_MakeDivline(struct line_s *li, divline_t *dl);
 fixed_t P_InterceptVector(divline_t *v2, divline_t *v1);
 int     P_BoxOnLineSide(fixed_t *tmbox, struct line_s *ld);
+void    P_InitLineBoxes(void);
 void    P_LineOpening(struct line_s *linedef);
 void    P_UnsetThingPosition(struct mobj_s *thing);
 void    P_SetThingPosition(struct mobj_s *thing);
 boolean P_BlockLinesIterator (int x, int y, boolean func(struct line_s *));
 boolean P_BlockThingsIterator(int x, int y, boolean func(struct mobj_s *),
                               boolean do_blockmapfix);
+void    P_InvalidateCorpseIndex(void);
+void    P_UpdateCorpseIndex(struct mobj_s *thing);
+boolean P_BlockCorpsesIterator(int x, int y, boolean func(struct mobj_s *),
+                               boolean do_blockmapfix);
 boolean ThingIsOnLine(struct mobj_s *t, struct line_s *l);  // killough 3/15/98
 boolean P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2,
                        int flags, boolean trav(intercept_t *));
+void P_InterceptBenchmark(void);
 
 angle_t P_PointToAngle(fixed_t xo, fixed_t yo, fixed_t x, fixed_t y);
 struct mobj_s *P_RoughTargetSearch(struct mobj_s *mo, angle_t fov, int distance);
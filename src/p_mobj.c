@@ -33,6 +33,7 @@
 #include "p_map.h"
 #include "p_maputl.h"
 #include "p_mobj.h"
+#include "p_profile.h"
 #include "p_pspr.h"
 #include "p_setup.h"
 #include "p_spec.h"
@@ -117,7 +118,17 @@ boolean P_SetMobjState(mobj_t* mobj,statenum_t state)
       // Call action functions when the state is set
 
       if (st->action.p1)
-	st->action.p1(mobj);
+      {
+        // [Woof!] playsim profiler
+        if (playsim_profiling)
+        {
+          P_ProfileEnter(st->action.v, profile_action);
+          st->action.p1(mobj);
+          P_ProfileLeave();
+        }
+        else
+          st->action.p1(mobj);
+      }
 
       seenstate[state] = 1 + st->nextstate;   // killough 4/9/98
 
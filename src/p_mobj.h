@@ -286,6 +286,8 @@ typedef struct mobj_s
     // Links in blocks (if needed).
     struct mobj_s*      bnext;
     struct mobj_s**     bprev; // killough 8/11/98: change to ptr-to-ptr
+    int                 blockcell;  // [Woof!] index in blocklinks + 1, or 0
+    int                 corpsecell; // [Woof!] cell counted in corpse index
     
     struct subsector_s* subsector;
 
@@ -334,7 +336,7 @@ typedef struct mobj_s
     int32_t             tint;
 
     // Translucency
-    byte*               tranmap;
+    const byte*         tranmap;
 
     // Movement direction, movement generation (zig-zagging).
     short               movedir;        // 0-7
@@ -395,6 +397,11 @@ typedef struct mobj_s
     // a linked list of sectors where this object appears
     struct msecnode_s* touching_sectorlist;                 // phares 3/14/98
 
+    // [Woof!] While the object's box stays within this one, it touches no
+    // other sector than the one it is in (see P_CreateSecNodeList).
+    fixed_t secnodebox[4];
+    boolean secnodesafe;
+
     // SEE WARNING ABOVE ABOUT POINTER FIELDS!!!
 
     // [AM] If true, ok to interpolate this tic.
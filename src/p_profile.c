@@ -0,0 +1,253 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Playsim profiler, time and calls per thinker and action function.
+//
+//      Each function gets the total time of its calls and the self time,
+//      which excludes the nested calls. Action functions run from within
+//      thinkers, so the self times add up to the whole time spent in the
+//      profiled calls.
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "deh_main.h"
+#include "doomtype.h"
+#include "i_exit.h"
+#include "i_printf.h"
+#include "i_timer.h"
+#include "m_argv.h"
+#include "m_hashmap.h"
+#include "p_ambient.h"
+#include "p_profile.h"
+#include "p_setup.h"
+#include "p_spec.h"
+#include "p_tick.h"
+#include "p_user.h"
+
+#define MAX_DEPTH 64
+
+typedef struct
+{
+    actionf_v function;
+    profile_kind_t kind;
+    uint64_t calls;
+    uint64_t total; // ns
+    uint64_t self;
+} profile_entry_t;
+
+typedef struct
+{
+    actionf_v function;
+    profile_kind_t kind;
+    uint64_t start;
+    uint64_t nested; // ns spent in nested calls
+} profile_frame_t;
+
+boolean playsim_profiling;
+
+static hashmap_t *entries;
+static profile_frame_t stack[MAX_DEPTH];
+static int depth, overflow;
+static uint64_t playsim_time;
+
+#define THINKER(func) {(actionf_v)func, #func}
+
+static const struct
+{
+    actionf_v function;
+    const char *name;
+} thinker_names[] = {
+    THINKER(P_MobjThinker),
+    THINKER(P_DegenMobjThinker),
+    THINKER(P_PlayerThink),
+    THINKER(T_LightFlashAdapter),
+    THINKER(T_StrobeFlashAdapter),
+    THINKER(T_GlowAdapter),
+    THINKER(T_FireFlickerAdapter),
+    THINKER(T_PlatRaiseAdapter),
+    THINKER(T_VerticalDoorAdapter),
+    THINKER(T_MoveCeilingAdapter),
+    THINKER(T_MoveFloorAdapter),
+    THINKER(T_MoveElevatorAdapter),
+    THINKER(T_ScrollAdapter),
+    THINKER(T_FrictionAdapter),
+    THINKER(T_PusherAdapter),
+    THINKER(T_ParamScrollFloorAdapter),
+    THINKER(T_ParamScrollCeilingAdapter),
+    THINKER(T_AmbientSoundAdapter),
+    THINKER(P_RemoveMobjThinkerDelayed),
+    THINKER(P_RemoveCeilingThinkerDelayed),
+    THINKER(P_RemoveDoorThinkerDelayed),
+    THINKER(P_RemoveFloorThinkerDelayed),
+    THINKER(P_RemoveElevatorThinkerDelayed),
+    THINKER(P_RemovePlatThinkerDelayed),
+    THINKER(P_RemoveAmbientThinkerDelayed),
+};
+
+static void GetName(const profile_entry_t *entry, char *buffer, int size)
+{
+    if (entry->kind == profile_action)
+    {
+        const char *name = DEH_ActionName(entry->function);
+
+        if (name)
+        {
+            snprintf(buffer, size, "A_%s", name);
+            return;
+        }
+    }
+    else
+    {
+        for (int i = 0; i < arrlen(thinker_names); ++i)
+        {
+            if (thinker_names[i].function == entry->function)
+            {
+                snprintf(buffer, size, "%s", thinker_names[i].name);
+                return;
+            }
+        }
+    }
+
+    snprintf(buffer, size, "%s %#llx",
+             entry->kind == profile_action ? "action" : "thinker",
+             (unsigned long long)(uintptr_t)entry->function);
+}
+
+static int CompareEntries(const void *a, const void *b)
+{
+    const profile_entry_t *x = *(const profile_entry_t **)a;
+    const profile_entry_t *y = *(const profile_entry_t **)b;
+
+    return (x->self < y->self) - (x->self > y->self);
+}
+
+static void PrintReport(void)
+{
+    const int count = hashmap_size(entries);
+    profile_entry_t **sorted = malloc(count * sizeof(*sorted));
+    profile_entry_t *entry;
+    int i = 0;
+
+    hashmap_foreach(entry, entries)
+    {
+        sorted[i++] = entry;
+    }
+
+    qsort(sorted, count, sizeof(*sorted), CompareEntries);
+
+    I_Printf(VB_ALWAYS, "%-32s %12s %10s %10s %6s %8s", "Function", "Calls",
+             "Total (ms)", "Self (ms)", "Self %", "ns/call");
+
+    for (i = 0; i < count; ++i)
+    {
+        char name[33];
+
+        entry = sorted[i];
+        GetName(entry, name, sizeof(name));
+
+        I_Printf(VB_ALWAYS, "%-32s %12llu %10.2f %10.2f %6.1f %8.0f", name,
+                 (unsigned long long)entry->calls, entry->total / 1000000.0,
+                 entry->self / 1000000.0,
+                 playsim_time ? 100.0 * entry->self / playsim_time : 0.0,
+                 (double)entry->total / entry->calls);
+    }
+
+    I_Printf(VB_ALWAYS, "%-32s %12s %10.2f", "Total", "",
+             playsim_time / 1000000.0);
+
+    if (overflow)
+    {
+        I_Printf(VB_WARNING, "P_Profile: %d calls nested too deeply.",
+                 overflow);
+    }
+
+    free(sorted);
+    hashmap_free(entries);
+    entries = NULL;
+}
+
+void P_InitProfiler(void)
+{
+    //!
+    // @category obscure
+    //
+    // Measure the time spent in each thinker and action function and print
+    // a report sorted by time at exit.
+    //
+
+    if (!M_ParmExists("-profileplaysim"))
+    {
+        return;
+    }
+
+    entries = hashmap_init(256, sizeof(profile_entry_t));
+    playsim_profiling = true;
+
+    I_AtExit(PrintReport, false);
+}
+
+void P_ProfileEnter(actionf_v function, profile_kind_t kind)
+{
+    if (depth == MAX_DEPTH)
+    {
+        overflow++;
+        depth++;
+        return;
+    }
+
+    profile_frame_t *frame = &stack[depth++];
+
+    frame->function = function;
+    frame->kind = kind;
+    frame->nested = 0;
+    frame->start = I_GetTimeNS();
+}
+
+void P_ProfileLeave(void)
+{
+    const uint64_t now = I_GetTimeNS();
+
+    if (depth-- > MAX_DEPTH)
+    {
+        return;
+    }
+
+    const profile_frame_t *frame = &stack[depth];
+    const uint64_t elapsed = now - frame->start;
+    const uint64_t key = (uintptr_t)frame->function;
+    profile_entry_t *entry = hashmap_get(entries, key);
+
+    if (!entry)
+    {
+        profile_entry_t new_entry = {frame->function, frame->kind};
+        hashmap_put(entries, key, &new_entry);
+        entry = hashmap_get(entries, key);
+    }
+
+    entry->calls++;
+    entry->total += elapsed;
+    entry->self += elapsed - frame->nested;
+
+    if (depth > 0)
+    {
+        stack[depth - 1].nested += elapsed;
+    }
+    else
+    {
+        playsim_time += elapsed;
+    }
+}
@@ -0,0 +1,38 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Playsim profiler, time and calls per thinker and action function.
+//
+
+#ifndef __P_PROFILE__
+#define __P_PROFILE__
+
+#include "d_think.h"
+#include "doomtype.h"
+
+typedef enum
+{
+    profile_thinker,
+    profile_action,
+} profile_kind_t;
+
+extern boolean playsim_profiling;
+
+void P_InitProfiler(void);
+
+// Brackets a call of a thinker or action function. Calls may nest.
+void P_ProfileEnter(actionf_v function, profile_kind_t kind);
+void P_ProfileLeave(void);
+
+#endif
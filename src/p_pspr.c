@@ -33,6 +33,7 @@
 #include "p_inter.h"
 #include "p_map.h"
 #include "p_mobj.h"
+#include "p_profile.h"
 #include "p_pspr.h"
 #include "p_tick.h"
 #include "p_user.h"
@@ -134,7 +135,12 @@ void P_SetPspritePtr(player_t *player, pspdef_t *psp, statenum_t stnum)
       // Modified handling.
       if (state->action.p2)
         {
+          // [Woof!] playsim profiler
+          if (playsim_profiling)
+            P_ProfileEnter(state->action.v, profile_action);
           state->action.p2(player, psp);
+          if (playsim_profiling)
+            P_ProfileLeave();
           if (!psp->state)
             break;
         }
@@ -0,0 +1,454 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Build a conservative REJECT table with the worker threads.
+//
+//      Most node builders write an all-zero REJECT lump, so every sight
+//      check ends up in a full BSP traversal. For such maps, the table is
+//      computed by flooding from every sector through the two-sided lines
+//      ("portals"). A line of sight crosses portals in order, and each pair
+//      of portals along it must be at least partially in front of the other.
+//      Only portals that pass this test against the first and the previous
+//      portal are followed, and sectors that are never reached can not be
+//      seen. Heights are ignored since they change during the game.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "doomdata.h"
+#include "doomstat.h"
+#include "i_exit.h"
+#include "i_printf.h"
+#include "i_system.h"
+#include "i_thread.h"
+#include "m_argv.h"
+#include "m_fixed.h"
+#include "p_reject.h"
+#include "p_setup.h"
+#include "r_defs.h"
+#include "r_state.h"
+#include "z_zone.h"
+
+sightstats_t sightstats;
+
+typedef struct
+{
+    // in 1/16 map units, so that cross products fit into 64 bits
+    int64_t x1, y1, x2, y2;
+    int dest;
+} portal_t;
+
+typedef struct
+{
+    int first, last; // source sectors
+    int *visited;    // per portal, number of the last flood that reached it
+    int *stack;
+    int rejected;
+} rejectjob_t;
+
+static portal_t *portals;
+static int *sector_portals; // index of the first portal of each sector
+static int num_portals;
+
+static byte *new_reject;
+static rejectjob_t *jobs;
+static int num_jobs;
+
+static int64_t ToPortalUnits(fixed_t x)
+{
+    return x >> (FRACBITS - 4);
+}
+
+//
+// Returns true if any endpoint of `b` is on the left of `a` or on it, within
+// one map unit. The tolerance also covers the rounding to portal units.
+//
+
+static boolean InFront(const portal_t *a, const portal_t *b)
+{
+    const int64_t dx = a->x2 - a->x1;
+    const int64_t dy = a->y2 - a->y1;
+    const int64_t tolerance = (llabs(dx) + llabs(dy) + 2) * 16;
+
+    return dx * (b->y1 - a->y1) - dy * (b->x1 - a->x1) >= -tolerance
+           || dx * (b->y2 - a->y1) - dy * (b->x2 - a->x1) >= -tolerance;
+}
+
+static boolean InBack(const portal_t *a, const portal_t *b)
+{
+    const int64_t dx = a->x2 - a->x1;
+    const int64_t dy = a->y2 - a->y1;
+    const int64_t tolerance = (llabs(dx) + llabs(dy) + 2) * 16;
+
+    return dx * (b->y1 - a->y1) - dy * (b->x1 - a->x1) <= tolerance
+           || dx * (b->y2 - a->y1) - dy * (b->x2 - a->x1) <= tolerance;
+}
+
+// `b` may follow `a` on a line of sight.
+static boolean CanFollow(const portal_t *a, const portal_t *b)
+{
+    return InFront(a, b) && InBack(b, a);
+}
+
+static void FloodSector(rejectjob_t *job, int source, byte *visible,
+                        int *stamp)
+{
+    visible[source] = true;
+
+    for (int first = sector_portals[source];
+         first < sector_portals[source + 1]; ++first)
+    {
+        const portal_t *p0 = &portals[first];
+        int top = 0;
+
+        ++*stamp;
+        job->visited[first] = *stamp;
+        job->stack[top++] = first;
+
+        while (top > 0)
+        {
+            const portal_t *p = &portals[job->stack[--top]];
+
+            visible[p->dest] = true;
+
+            for (int next = sector_portals[p->dest];
+                 next < sector_portals[p->dest + 1]; ++next)
+            {
+                const portal_t *q = &portals[next];
+
+                if (job->visited[next] == *stamp || !CanFollow(p0, q)
+                    || !CanFollow(p, q))
+                {
+                    continue;
+                }
+
+                job->visited[next] = *stamp;
+                job->stack[top++] = next;
+            }
+        }
+    }
+}
+
+static void RejectJob(void *data)
+{
+    rejectjob_t *job = data;
+    byte *visible = malloc(numsectors);
+    int stamp = 0;
+
+    job->visited = calloc(num_portals, sizeof(*job->visited));
+    job->stack = malloc(num_portals * sizeof(*job->stack));
+
+    for (int source = job->first; source < job->last; ++source)
+    {
+        memset(visible, 0, numsectors);
+
+        FloodSector(job, source, visible, &stamp);
+
+        for (int target = 0; target < numsectors; ++target)
+        {
+            if (!visible[target])
+            {
+                const int pnum = source * numsectors + target;
+                new_reject[pnum >> 3] |= 1 << (pnum & 7);
+                job->rejected++;
+            }
+        }
+    }
+
+    free(visible);
+    free(job->visited);
+    free(job->stack);
+}
+
+static int CompareKeys(const void *a, const void *b)
+{
+    const uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+//
+// The flood relies on every sector being closed and on the sector of every
+// subsector matching its segs. Maps that play tricks with either are left
+// alone.
+//
+
+static boolean CheckGeometry(void)
+{
+    uint64_t *keys = malloc(numlines * 4 * sizeof(*keys));
+    int num_keys = 0;
+    boolean result = true;
+
+    for (int i = 0; i < numlines && result; ++i)
+    {
+        const line_t *ld = &lines[i];
+
+        if (ld->frontsector == ld->backsector
+            || ((ld->flags & ML_TWOSIDED) && !ld->backsector))
+        {
+            result = false;
+            break;
+        }
+
+        for (int side = 0; side < 2; ++side)
+        {
+            const sector_t *sector = side ? ld->backsector : ld->frontsector;
+
+            if (sector)
+            {
+                const uint64_t s = (uint64_t)(sector - sectors) << 32;
+                keys[num_keys++] = s | (uint64_t)(ld->v1 - vertexes);
+                keys[num_keys++] = s | (uint64_t)(ld->v2 - vertexes);
+            }
+        }
+    }
+
+    // Every vertex of a closed sector is shared by an even number of its
+    // lines.
+    if (result)
+    {
+        qsort(keys, num_keys, sizeof(*keys), CompareKeys);
+
+        for (int i = 0; i < num_keys;)
+        {
+            int j = i + 1;
+
+            while (j < num_keys && keys[j] == keys[i])
+            {
+                j++;
+            }
+
+            if ((j - i) & 1)
+            {
+                result = false;
+                break;
+            }
+
+            i = j;
+        }
+    }
+
+    free(keys);
+
+    for (int i = 0; i < numsubsectors && result; ++i)
+    {
+        const subsector_t *ss = &subsectors[i];
+
+        for (int j = 0; j < ss->numlines; ++j)
+        {
+            if (segs[ss->firstline + j].frontsector != ss->sector)
+            {
+                result = false;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void AddPortal(const vertex_t *v1, const vertex_t *v2,
+                      const sector_t *source, const sector_t *dest,
+                      int *count)
+{
+    const int index = count[source - sectors]++;
+    portal_t *portal = &portals[index];
+
+    portal->x1 = ToPortalUnits(v1->x);
+    portal->y1 = ToPortalUnits(v1->y);
+    portal->x2 = ToPortalUnits(v2->x);
+    portal->y2 = ToPortalUnits(v2->y);
+    portal->dest = dest - sectors;
+}
+
+static void InitPortals(void)
+{
+    int *count = calloc(numsectors + 1, sizeof(*count));
+
+    num_portals = 0;
+
+    for (int i = 0; i < numlines; ++i)
+    {
+        const line_t *ld = &lines[i];
+
+        if (ld->backsector)
+        {
+            count[ld->frontsector - sectors]++;
+            count[ld->backsector - sectors]++;
+            num_portals += 2;
+        }
+    }
+
+    sector_portals = malloc((numsectors + 1) * sizeof(*sector_portals));
+    sector_portals[0] = 0;
+    for (int i = 0; i < numsectors; ++i)
+    {
+        sector_portals[i + 1] = sector_portals[i] + count[i];
+        count[i] = sector_portals[i];
+    }
+
+    portals = malloc(num_portals * sizeof(*portals));
+
+    // The front side of a line is on its right, so the destination of a
+    // portal is always on its left.
+    for (int i = 0; i < numlines; ++i)
+    {
+        const line_t *ld = &lines[i];
+
+        if (ld->backsector)
+        {
+            AddPortal(ld->v1, ld->v2, ld->frontsector, ld->backsector, count);
+            AddPortal(ld->v2, ld->v1, ld->backsector, ld->frontsector, count);
+        }
+    }
+
+    free(count);
+}
+
+static void FreePortals(void)
+{
+    free(portals);
+    free(sector_portals);
+    free(jobs);
+    portals = NULL;
+    sector_portals = NULL;
+    jobs = NULL;
+}
+
+boolean P_CanBuildReject(void)
+{
+    //!
+    // @category mod
+    //
+    // Build a REJECT table for maps that don't have one.
+    //
+
+    // The sight checks round coordinates in places, so a map might still
+    // allow lines of sight that the flood does not find. Don't risk a
+    // desync in recordings or in the playback of demos recorded without
+    // the table.
+    return M_ParmExists("-buildreject")
+           && !demorecording && !demoplayback && !netgame;
+}
+
+//
+// The table is built while the level is set up, so that every tic of the
+// level sees the same table, no matter how fast the workers are.
+//
+
+void P_BuildReject(void)
+{
+    static boolean first = true;
+
+    if (!P_CanBuildReject() || numsectors == 0)
+    {
+        return;
+    }
+
+    if (first)
+    {
+        I_AtExit(P_ReportSightStats, false);
+        first = false;
+    }
+
+    // Only replace tables that reject nothing.
+    const int length = (numsectors * numsectors + 7) / 8;
+
+    for (int i = 0; i < length; ++i)
+    {
+        if (rejectmatrix[i])
+        {
+            return;
+        }
+    }
+
+    if (I_NumWorkerThreads() == 0)
+    {
+        I_Printf(VB_DEBUG, "P_BuildReject: No worker threads.");
+        return;
+    }
+
+    if (!CheckGeometry())
+    {
+        I_Printf(VB_DEBUG, "P_BuildReject: Unsupported map geometry.");
+        return;
+    }
+
+    InitPortals();
+
+    new_reject = Z_Malloc(length, PU_LEVEL, NULL);
+    memset(new_reject, 0, length);
+
+    // Jobs write whole bytes of the table, so their rows must start at a
+    // multiple of 8 bits.
+    num_jobs = I_NumWorkerThreads() * 4;
+    jobs = calloc(num_jobs, sizeof(*jobs));
+
+    int start = 0;
+
+    for (int i = 0; i < num_jobs; ++i)
+    {
+        int end = (int64_t)numsectors * (i + 1) / num_jobs;
+
+        while (end < numsectors && (int64_t)end * numsectors % 8)
+        {
+            end++;
+        }
+
+        jobs[i].first = start;
+        jobs[i].last = end;
+        start = end;
+    }
+
+    jobgroup_t *group = I_CreateJobGroup();
+
+    for (int i = 0; i < num_jobs; ++i)
+    {
+        if (jobs[i].first < jobs[i].last)
+        {
+            I_AddJob(group, RejectJob, &jobs[i]);
+        }
+    }
+
+    I_WaitJobGroup(group);
+
+    int rejected = 0;
+
+    for (int i = 0; i < num_jobs; ++i)
+    {
+        rejected += jobs[i].rejected;
+    }
+
+    I_Printf(VB_DEBUG, "P_BuildReject: %d of %d sector pairs rejected.",
+             rejected, numsectors * numsectors);
+
+    rejectmatrix = new_reject;
+    new_reject = NULL;
+
+    FreePortals();
+}
+
+void P_ReportSightStats(void)
+{
+    if (sightstats.checks)
+    {
+        I_Printf(VB_DEBUG,
+                 "P_CheckSight: %d checks, %d rejected, %d cached, "
+                 "%d traversals.",
+                 sightstats.checks, sightstats.rejected, sightstats.cached,
+                 sightstats.traversals);
+    }
+
+    memset(&sightstats, 0, sizeof(sightstats));
+}
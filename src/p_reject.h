@@ -0,0 +1,42 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Build a conservative REJECT table with the worker threads.
+//
+
+#ifndef __P_REJECT__
+#define __P_REJECT__
+
+#include "doomtype.h"
+
+typedef struct
+{
+    int checks;     // calls to P_CheckSight()
+    int rejected;   // answered by the REJECT table
+    int cached;     // answered by an earlier traversal in the same tic
+    int traversals; // answered by a full line of sight traversal
+} sightstats_t;
+
+extern sightstats_t sightstats;
+
+// Whether the current game may use a table built by P_BuildReject().
+boolean P_CanBuildReject(void);
+
+// Called after the level geometry has been loaded, replaces an empty table.
+void P_BuildReject(void);
+
+// Called before the level is freed.
+void P_ReportSightStats(void);
+
+#endif
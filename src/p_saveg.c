@@ -31,6 +31,7 @@
 #include "m_array.h"
 #include "m_random.h"
 #include "p_enemy.h"
+#include "p_map.h"
 #include "p_maputl.h"
 #include "p_mobj.h"
 #include "p_pspr.h"
@@ -81,7 +82,8 @@ static thinker_t *P_IndexToThinker(int index)
         return NULL;
     }
 
-    for (th = thinkercap.next, i = 0; th != &thinkercap; th = th->next)
+    for (th = thinkerkindcap[tk_mobj].knext, i = 0;
+         th != &thinkerkindcap[tk_mobj]; th = th->knext)
     {
         if (th->function.p1 == P_MobjThinker)
         {
@@ -300,6 +302,9 @@ static void saveg_read_mobj_t(mobj_t *str)
     // struct msecnode_s* touching_sectorlist;
     str->touching_sectorlist = saveg_readp();
 
+    // [Woof!] the sector list is rebuilt, see P_CreateSecNodeList()
+    str->secnodesafe = false;
+
     if (saveg_compat > saveg_mbf)
     {
         // [Woof!]: int interp;
@@ -1125,6 +1130,8 @@ void P_UnArchiveWorld(void)
             }
         }
     }
+
+    P_InvalidateSightCache(); // [Woof!] heights were restored
 }
 
 //
@@ -1165,6 +1172,9 @@ void P_UnArchiveThinkers(void)
     size_t size;     // killough 2/14/98: size of or index into table
     size_t idx;      // haleyjd 11/03/06: separate index var
 
+    // [Woof!] rebuilt from the restored blockmap on first use
+    P_InvalidateCorpseIndex();
+
     // killough 3/26/98: Load boss brain state
     brain.easy = saveg_read32();
     brain.targeton = saveg_read32();
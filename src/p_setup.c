@@ -32,11 +32,15 @@
 #include "g_compatibility.h"
 #include "i_printf.h"
 #include "i_system.h"
+#include "i_thread.h"
+#include "i_timer.h"
 #include "info.h"
 #include "m_arena.h"
 #include "m_argv.h"
+#include "m_array.h"
 #include "m_bbox.h"
 #include "m_fixed.h"
+#include "m_hashmap.h"
 #include "m_misc.h"
 #include "m_swap.h"
 #include "nano_bsp.h"
@@ -45,6 +49,8 @@
 #include "p_map.h"
 #include "p_maputl.h"
 #include "p_mobj.h"
+#include "p_profile.h"
+#include "p_reject.h"
 #include "p_setup.h"
 #include "p_spec.h"
 #include "p_tick.h"
@@ -118,6 +124,7 @@ side_t   *sides;
 
 int      *sslines_indexes;
 ssline_t *sslines;
+linebox_t *lineboxes;
 
 arena_t *world_arena;
 
@@ -137,6 +144,7 @@ int32_t      *blockmap;           // was short -- killough
 
 // offsets in blockmap are from here
 int32_t      *blockmaplump;       // was short -- killough
+int          blockmaplump_size;  // [Woof!] in elements
 
 fixed_t   bmaporgx, bmaporgy;     // origin of block map
 
@@ -830,7 +838,8 @@ int P_GroupLines (void)
 
 void P_RemoveSlimeTrails(void)                // killough 10/98
 {
-  byte *hit = Z_Calloc(numvertexes, sizeof(*hit), PU_STATIC, 0); // Hitlist for vertices
+  // [Woof!] not from the zone, this runs on a worker thread
+  byte *hit = calloc(numvertexes, sizeof(*hit)); // Hitlist for vertices
   int i;
   for (i=0; i<numsegs; i++)                   // Go through each seg
     {
@@ -876,7 +885,7 @@ void P_RemoveSlimeTrails(void)                // killough 10/98
 	  while ((v != segs[i].v2) && (v = segs[i].v2));
 	}
     }
-  Z_Free(hit);
+  free(hit);
 }
 
 // [crispy] fix long wall wobble
@@ -907,9 +916,9 @@ void P_SegLengths(void)
         li->r_length = (uint32_t)(sqrt((double)dx*dx + (double)dy*dy)/2);
 
         // [crispy] re-calculate angle used for rendering
-        viewx = li->v1->r_x;
-        viewy = li->v1->r_y;
-        li->r_angle = R_PointToAngleCrispy(li->v2->r_x, li->v2->r_y);
+        // [Woof!] not from viewx/viewy, this runs on a worker thread
+        li->r_angle = R_PointToAngle2Crispy(li->v1->r_x, li->v1->r_y,
+                                            li->v2->r_x, li->v2->r_y);
         // [crispy] more than just a little adjustment?
         // back to the original angle then
         if (anglediff(li->r_angle, li->angle) > ANG60/2)
@@ -1029,8 +1038,10 @@ static void LoadMap(map_t *map)
   P_LoadLineDefs (map->linedefs);                //       |
   P_LoadSideDefs2(map->sidedefs);                //       |
   P_LoadLineDefs2(map->linedefs);                // killough 4/4/98
-  map->bmap_format = P_LoadBlockMap(map->blockmap); // killough 3/1/98
+}
 
+static void LoadNodes(map_t *map)
+{
   // [FG] build nodes with NanoBSP
   if (map->bsp_format == BSP_NANO)
   {
@@ -1053,9 +1064,322 @@ static void LoadMap(map_t *map)
     P_LoadNodes(map->nodes);
     P_LoadSegs(map->segs);
   }
+}
+
+//
+// [Woof!] Level snapshot
+//
+// Restarting the same map, after a death or with the reload key, used to
+// load the geometry from the lumps again. Once the geometry is complete it
+// is copied, and the next setup of the same map with the same compatibility
+// settings restores the copy instead. The world arena is restored at the
+// same address, so all pointers into it stay valid. The zone blocks that
+// belong to the geometry are moved into the snapshot, which owns them until
+// another map is loaded.
+//
+
+typedef struct
+{
+  map_t map;
+  demo_version_t demo_version;
+  int comp[COMP_TOTAL];
+  boolean build_reject;
+  arena_copy_t *world;
+  node_t *nodes;
+  int32_t *blockmaplump;
+  byte *rejectmatrix;
+  vertex_t *new_vertexes; // created by the node builder
+} snapshot_t;
+
+static snapshot_t *snapshot;
+
+static void FreeLevelSnapshot(void)
+{
+  if (!snapshot)
+    return;
+
+  M_ArenaFreeCopy(snapshot->world);
+  free(snapshot->nodes);
+  free(snapshot->blockmaplump);
+  free(snapshot->rejectmatrix);
+  array_free(snapshot->new_vertexes);
+  free(snapshot);
+  snapshot = NULL;
+}
+
+static void *MoveLevelBlock(void *block, size_t size)
+{
+  void *copy = malloc(size ? size : 1);
+
+  if (block)
+  {
+    memcpy(copy, block, size);
+    Z_Free(block);
+  }
+
+  return copy;
+}
+
+// NanoBSP allocates the vertices it creates one by one, move them into a
+// single array.
+
+static vertex_t *MoveNewVertexes(void)
+{
+  hashmap_t *refs = hashmap_init(64, sizeof(int));
+  vertex_t *new_vertexes = NULL;
+
+  for (int i = 0; i < numsegs; i++)
+  {
+    vertex_t **v[2] = {&segs[i].v1, &segs[i].v2};
+
+    for (int j = 0; j < 2; j++)
+    {
+      if (*v[j] >= vertexes && *v[j] < vertexes + numvertexes)
+        continue;
+
+      int *ref = hashmap_get(refs, (uintptr_t)*v[j]);
+
+      if (!ref)
+      {
+        int num = array_size(new_vertexes);
+        hashmap_put(refs, (uintptr_t)*v[j], &num);
+        array_push(new_vertexes, **v[j]);
+      }
+    }
+  }
+
+  for (int i = 0; i < numsegs; i++)
+  {
+    vertex_t **v[2] = {&segs[i].v1, &segs[i].v2};
+
+    for (int j = 0; j < 2; j++)
+    {
+      int *ref = hashmap_get(refs, (uintptr_t)*v[j]);
+
+      if (ref)
+        *v[j] = &new_vertexes[*ref];
+    }
+  }
+
+  hashmap_free(refs);
+
+  return new_vertexes;
+}
+
+static void SaveLevelSnapshot(void)
+{
+  FreeLevelSnapshot();
+
+  snapshot = calloc(1, sizeof(*snapshot));
+
+  snapshot->map = map;
+  snapshot->demo_version = demo_version;
+  memcpy(snapshot->comp, comp, sizeof(comp));
+  snapshot->build_reject = P_CanBuildReject();
+
+  snapshot->new_vertexes = MoveNewVertexes();
+  snapshot->nodes = nodes =
+    MoveLevelBlock(nodes, numnodes * sizeof(*nodes));
+  snapshot->blockmaplump = blockmaplump =
+    MoveLevelBlock(blockmaplump, blockmaplump_size * sizeof(*blockmaplump));
+  blockmap = blockmaplump + 4;
+  snapshot->rejectmatrix = rejectmatrix =
+    MoveLevelBlock(rejectmatrix, (numsectors * numsectors + 7) / 8);
+
+  snapshot->world = M_ArenaCopy(world_arena);
+}
+
+static boolean RestoreLevelSnapshot(void)
+{
+  if (!snapshot
+      || snapshot->map.label != map.label
+      || snapshot->map.map_format != map.map_format
+      || snapshot->map.bsp_format != map.bsp_format
+      || snapshot->demo_version != demo_version
+      || memcmp(snapshot->comp, comp, sizeof(comp))
+      || snapshot->build_reject != P_CanBuildReject())
+  {
+    FreeLevelSnapshot();
+    return false;
+  }
+
+  M_ArenaRestore(world_arena, snapshot->world);
+
+  map = snapshot->map;
+  nodes = snapshot->nodes;
+  blockmaplump = snapshot->blockmaplump;
+  blockmap = blockmaplump + 4;
+  rejectmatrix = snapshot->rejectmatrix;
+
+  I_Printf(VB_DEBUG, "P_SetupLevel: restored level snapshot");
+
+  return true;
+}
+
+//
+// [Woof!] Level setup stages
+//
+// Once the lines and sectors are loaded, the remaining setup is a small
+// graph of stages. Stages that only compute from the geometry run on worker
+// threads, stages that use the zone or the WAD run on the main thread, in
+// waves: all stages whose dependencies are done are started together. The
+// table lists every stage after the stages it depends on, and that order is
+// used when there are no worker threads.
+//
 
+typedef enum
+{
+  stage_blockmap,
+  stage_nodes,
+  stage_reject,
+  stage_subsector_lines,
+  stage_slime_trails,
+  stage_line_boxes,
+  stage_seg_lengths,
+  stage_finish_blockmap,
+  stage_build_reject,
+  stage_snapshot,
+  NUMSTAGES
+} stagenum_t;
+
+#define STAGE(x) (1u << (x))
+
+typedef struct
+{
+  const char *name;
+  void (*func)(void);
+  unsigned int deps;  // stages that must be done first
+  boolean worker;     // may run on a worker thread
+  uint64_t time;
+} setupstage_t;
+
+static void StageBlockMap(void)
+{
+  // starts building the blockmap, the header is set right away
+  map.bmap_format = P_LoadBlockMap(map.blockmap); // killough 3/1/98
+}
+
+static void StageNodes(void)
+{
+  LoadNodes(&map);
+}
+
+static void StageReject(void)
+{
   // [FG] pad the REJECT table when the lump is too small
-  map->reject_built = P_LoadReject(map->reject, P_GroupLines());
+  map.reject_built = P_LoadReject(map.reject, P_GroupLines());
+}
+
+static void StageSlimeTrails(void)
+{
+  if (map.bsp_format != BSP_NANO)
+  {
+    P_RemoveSlimeTrails();    // killough 10/98: remove slime trails from wad
+  }
+}
+
+static void StageSnapshot(void)
+{
+  if (map.map_format == MAP_DOOM)
+  {
+    SaveLevelSnapshot();
+  }
+}
+
+static setupstage_t stages[NUMSTAGES] = {
+  [stage_blockmap] = {"blockmap", StageBlockMap, 0, false},
+  // the node loaders may move the vertexes, the blockmap has its copy
+  [stage_nodes] = {"nodes", StageNodes, STAGE(stage_blockmap), false},
+  // P_GroupLines() needs the blockmap header
+  [stage_reject] = {"reject", StageReject, STAGE(stage_nodes), false},
+  // P_CrossSubsector optimization
+  [stage_subsector_lines] = {"subsector lines", P_InitSubsectorLines,
+                             STAGE(stage_nodes), true},
+  // moves vertexes that other lines may share, P_GroupLines() must see the
+  // vertexes as they were loaded
+  [stage_slime_trails] = {"slime trails", StageSlimeTrails,
+                          STAGE(stage_reject), true},
+  // copies the final vertex coordinates
+  [stage_line_boxes] = {"line boxes", P_InitLineBoxes,
+                        STAGE(stage_slime_trails), true},
+  // [crispy] fix long wall wobble
+  [stage_seg_lengths] = {"seg lengths", P_SegLengths,
+                         STAGE(stage_slime_trails), true},
+  [stage_finish_blockmap] = {"finish blockmap", P_FinishBlockMap,
+                             STAGE(stage_reject), false},
+  // the flood needs the subsector sectors and the final vertexes
+  [stage_build_reject] = {"build reject", P_BuildReject,
+                          STAGE(stage_reject) | STAGE(stage_slime_trails),
+                          false},
+  [stage_snapshot] = {"snapshot", StageSnapshot,
+                      STAGE(NUMSTAGES) - 1 - STAGE(stage_snapshot), false},
+};
+
+static void RunStage(void *data)
+{
+  setupstage_t *stage = data;
+  const uint64_t start = I_GetTimeNS();
+
+  stage->func();
+
+  stage->time = I_GetTimeNS() - start;
+}
+
+static void RunSetupStages(void)
+{
+  const uint64_t start = I_GetTimeNS();
+  unsigned int done = 0;
+  int i;
+
+  // the serial order must agree with the dependencies
+  for (i = 0; i < NUMSTAGES; i++)
+    if (stages[i].deps & ~(STAGE(i) - 1))
+      I_Error("Stage '%s' depends on a later stage",
+              stages[i].name);
+
+  if (I_NumWorkerThreads() == 0)
+  {
+    for (i = 0; i < NUMSTAGES; i++)
+      RunStage(&stages[i]);
+  }
+  else
+  {
+    while (done != STAGE(NUMSTAGES) - 1)
+    {
+      unsigned int ready = 0;
+      jobgroup_t *group = NULL;
+
+      for (i = 0; i < NUMSTAGES; i++)
+        if (!(done & STAGE(i)) && (stages[i].deps & done) == stages[i].deps)
+          ready |= STAGE(i);
+
+      // start the worker stages first, they run while the main thread
+      // works on the rest of the wave
+      for (i = 0; i < NUMSTAGES; i++)
+        if ((ready & STAGE(i)) && stages[i].worker)
+        {
+          if (!group)
+            group = I_CreateJobGroup();
+          I_AddJob(group, RunStage, &stages[i]);
+        }
+
+      for (i = 0; i < NUMSTAGES; i++)
+        if ((ready & STAGE(i)) && !stages[i].worker)
+          RunStage(&stages[i]);
+
+      if (group)
+        I_WaitJobGroup(group);
+
+      done |= ready;
+    }
+  }
+
+  for (i = 0; i < NUMSTAGES; i++)
+    I_Printf(VB_DEBUG, "P_SetupLevel: %-16s %8.2f ms", stages[i].name,
+             stages[i].time / 1000000.0);
+
+  I_Printf(VB_DEBUG, "P_SetupLevel: %-16s %8.2f ms", "total",
+           (I_GetTimeNS() - start) / 1000000.0);
 }
 
 //
@@ -1229,8 +1553,11 @@ void P_SetupLevel(int episode, int map_num, skill_t skill)
   // Make sure all sounds are stopped before Z_FreeTags.
   S_Start();
 
+  P_ReportSightStats();
+  P_InvalidateSightCache(); // [Woof!]
+  P_ReportSecNodeStats();
+
   Z_FreeTag(PU_LEVEL);
-  M_ArenaClear(world_arena);
   M_ArenaClear(thinkers_arena);
   M_ArenaClear(msecnodes_arena);
 
@@ -1254,13 +1581,25 @@ void P_SetupLevel(int episode, int map_num, skill_t skill)
   leveltime = 0;
   oldleveltime = 0;
 
+  // [Woof!] Restore the geometry if the same map is loaded again. Not for
+  // UDMF maps, their things are spawned from the parsed TEXTMAP.
+  const boolean restored =
+    map.map_format == MAP_DOOM && RestoreLevelSnapshot();
+
+  if (!restored)
+  {
+    FreeLevelSnapshot();
+    M_ArenaClear(world_arena);
+  }
+
   switch (map.map_format)
   {
     case MAP_DOOM:
       // the original implementation used only low precision math
       P_PointOnLineSide = P_PointOnLineSide_Classic;
       P_PointOnDivlineSide = P_PointOnDivlineSide_Classic;
-      LoadMap(&map);
+      if (!restored)
+        LoadMap(&map);
       break;
     case MAP_HEXEN:
       I_Error("Unsupported Hexen level format in %s", lumpname);
@@ -1276,9 +1615,6 @@ void P_SetupLevel(int episode, int map_num, skill_t skill)
       break;
   }
 
-  // P_CrossSubsector optimization
-  P_InitSubsectorLines();
-
   // XGL3/ZGL3 provide high-precision partition lines
   if (map.bsp_format >= BSP_XGL3)
   {
@@ -1289,14 +1625,13 @@ void P_SetupLevel(int episode, int map_num, skill_t skill)
     R_PointOnSide = R_PointOnSide_Classic;
   }
 
-  if (map.bsp_format != BSP_NANO)
+  // The subsector lines and line boxes of the restored geometry are still
+  // in place, they are only freed when the next map is loaded.
+  if (!restored)
   {
-    P_RemoveSlimeTrails();    // killough 10/98: remove slime trails from wad
+    RunSetupStages();
   }
 
-  // [crispy] fix long wall wobble
-  P_SegLengths();
-
   // Note: you don't need to clear player queue slots --
   // a much simpler fix is in g_game.c -- killough 10/98
 
@@ -1362,6 +1697,14 @@ void P_SetupLevel(int episode, int map_num, skill_t skill)
   if (precache)
     R_PrecacheLevel();
 
+  // [Woof!] no composites are generated while rendering
+  R_GenerateLevelComposites();
+
+  // [Woof!] the additive tranmap is generated in the background at startup
+  R_WaitTranMaps();
+
+  P_InterceptBenchmark();
+
   // [FG] log level setup
   I_Printf(VB_DEMO, "P_SetupLevel: %.8s (%s), Skill %d, %s (%s%s%s), %s",
     lumpname, W_WadNameForLump(lumpnum),
@@ -1378,6 +1721,7 @@ void P_SetupLevel(int episode, int map_num, skill_t skill)
 //
 void P_Init (void)
 {
+  P_InitProfiler();
   P_InitSwitchList();
   P_InitPicAnims();
   R_InitSprites(sprnames);
@@ -37,6 +37,7 @@ extern byte     *rejectmatrix;   // for fast sight rejection
 
 // killough 3/1/98: change blockmap from "short" to "long" offsets:
 extern int32_t  *blockmaplump;   // offsets in blockmap are from here
+extern int      blockmaplump_size;
 extern int32_t  *blockmap;
 extern int      bmapwidth;
 extern int      bmapheight;      // in mapblocks
@@ -52,7 +53,10 @@ void P_DegenMobjThinker(struct mobj_s *mobj);
 void P_SegLengths(void);
 
 
+// [Woof!] A built blockmap may still be in progress when P_LoadBlockMap()
+// returns, only the header is set. P_FinishBlockMap() waits for it.
 bmap_format_t P_LoadBlockMap(int lump);
+void P_FinishBlockMap(void);
 
 int P_GroupLines(void);
 int P_LoadReject(int lumpnum, int totallines);
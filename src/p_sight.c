@@ -23,8 +23,10 @@
 #include "i_system.h"
 #include "m_bbox.h"
 #include "m_fixed.h"
+#include "p_map.h"
 #include "p_maputl.h"
 #include "p_mobj.h"
+#include "p_reject.h"
 #include "p_setup.h"
 #include "r_defs.h"
 #include "r_main.h"
@@ -219,6 +221,40 @@ static boolean P_CrossBSPNode(int bspnum, register los_t *los)
   return P_CrossSubsector(bspnum == -1 ? 0 : bspnum & ~NF_SUBSECTOR, los);
 }
 
+//
+// [Woof!] Monsters check the same targets over and over within a tic. The
+// result of a traversal only depends on the positions of both things and
+// on the plane heights, so it is kept until the next tic or until any
+// plane moves. Sector heights are only written by T_MovePlane during play
+// and by level setup, savegame and keyframe restores, which all invalidate
+// the cache. Whether a line blocks sight (ML_TWOSIDED) is only set at setup.
+//
+
+#define SIGHTCACHE_SIZE 1024
+
+typedef struct
+{
+  unsigned int epoch;
+  mobj_t *t1, *t2;
+  fixed_t x1, y1, z1, height1;
+  fixed_t x2, y2, z2, height2;
+  boolean result;
+} sightcache_t;
+
+static sightcache_t sightcache[SIGHTCACHE_SIZE];
+static unsigned int sightcache_epoch = 1;
+
+void P_InvalidateSightCache(void)
+{
+  sightcache_epoch++;
+}
+
+static int SightCacheSlot(const mobj_t *t1, const mobj_t *t2)
+{
+  const uintptr_t key = ((uintptr_t)t1 >> 4) * 31 + ((uintptr_t)t2 >> 4);
+  return (key ^ (key >> 10)) & (SIGHTCACHE_SIZE - 1);
+}
+
 //
 // P_CheckSight
 // Returns true
@@ -233,6 +269,9 @@ static boolean P_CheckSight_MBF(mobj_t *t1, mobj_t *t2)
   const sector_t *s2 = t2->subsector->sector;
   int pnum = (s1-sectors)*numsectors + (s2-sectors);
   los_t los;
+  sightcache_t *entry;
+
+  sightstats.checks++;
 
   // First check for trivial rejection.
   // Determine subsector entries in REJECT table.
@@ -240,7 +279,10 @@ static boolean P_CheckSight_MBF(mobj_t *t1, mobj_t *t2)
   // Check in REJECT table.
 
   if (rejectmatrix[pnum>>3] & (1 << (pnum&7)))   // can't possibly be connected
+  {
+    sightstats.rejected++;
     return false;
+  }
 
   // killough 4/19/98: make fake floors and ceilings block monster view
   if ((s1->heightsec != -1 &&
@@ -262,6 +304,19 @@ static boolean P_CheckSight_MBF(mobj_t *t1, mobj_t *t2)
   if (t1->subsector == t2->subsector && demo_version >= DV_MBF)     // same subsector? obviously visible
     return true;
 
+  // [Woof!] Same pair at the same positions since the last plane move?
+  entry = &sightcache[SightCacheSlot(t1, t2)];
+
+  if (entry->epoch == sightcache_epoch && entry->t1 == t1 && entry->t2 == t2
+      && entry->x1 == t1->x && entry->y1 == t1->y && entry->z1 == t1->z
+      && entry->height1 == t1->height && entry->x2 == t2->x
+      && entry->y2 == t2->y && entry->z2 == t2->z
+      && entry->height2 == t2->height)
+  {
+    sightstats.cached++;
+    return entry->result;
+  }
+
   // An unobstructed LOS is possible.
   // Now look from eyes of t1 to any part of t2.
 
@@ -283,8 +338,24 @@ static boolean P_CheckSight_MBF(mobj_t *t1, mobj_t *t2)
   else
     los.bbox[BOXTOP] = t2->y, los.bbox[BOXBOTTOM] = t1->y;
 
+  sightstats.traversals++;
+
+  entry->epoch = sightcache_epoch;
+  entry->t1 = t1;
+  entry->t2 = t2;
+  entry->x1 = t1->x;
+  entry->y1 = t1->y;
+  entry->z1 = t1->z;
+  entry->height1 = t1->height;
+  entry->x2 = t2->x;
+  entry->y2 = t2->y;
+  entry->z2 = t2->z;
+  entry->height2 = t2->height;
+
   // the head node is the last node output
-  return P_CrossBSPNode(numnodes-1, &los);
+  entry->result = P_CrossBSPNode(numnodes-1, &los);
+
+  return entry->result;
 }
 
 boolean checksight12;
@@ -229,6 +229,26 @@ void P_InitPicAnims (void)
   Z_ChangeTag (animdefs,PU_CACHE); //jff 3/23/98 allow table to be freed
 }
 
+// [Woof!] Marks every frame of the texture animations that include a marked
+// texture, so that their composites can be generated up front.
+void P_MarkAnimatedTextures(byte *hitlist)
+{
+  for (const anim_t *anim = anims; anim < lastanim; anim++)
+  {
+    if (!anim->istexture || anim->numpics <= 0)
+      continue;
+
+    for (int i = anim->basepic; i <= anim->picnum; i++)
+    {
+      if (hitlist[i])
+      {
+        memset(hitlist + anim->basepic, 1, anim->numpics);
+        break;
+      }
+    }
+  }
+}
+
 // [FG] play sound when hitting animated floor
 void P_HitFloor (mobj_t *mo, int oof)
 {
@@ -3215,6 +3235,34 @@ void T_ParamScrollCeilingAdapter(mobj_t *mobj)
     T_ParamScrollCeiling((scroll_t *)mobj);
 }
 
+// [Woof!] Runs consecutive scroller thinkers, see P_RunThinkers().
+
+void T_RunScrollerBatch(thinker_t *const *thinkers, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        thinker_t *thinker = thinkers[i];
+        const actionf_p1 function = thinker->function.p1;
+
+        if (function == T_ScrollAdapter)
+        {
+            T_Scroll((scroll_t *)thinker);
+        }
+        else if (function == T_ParamScrollFloorAdapter)
+        {
+            T_ParamScrollFloor((scroll_t *)thinker);
+        }
+        else if (function == T_ParamScrollCeilingAdapter)
+        {
+            T_ParamScrollCeiling((scroll_t *)thinker);
+        }
+        else if (function)
+        {
+            function((mobj_t *)thinker);
+        }
+    }
+}
+
 //
 // Add_Scroller()
 //
@@ -3927,6 +3975,30 @@ void T_PusherAdapter(mobj_t *mobj)
     T_Pusher((pusher_t *)mobj);
 }
 
+// [Woof!] Runs consecutive pusher and friction thinkers, see P_RunThinkers().
+
+void T_RunPusherBatch(thinker_t *const *thinkers, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        thinker_t *thinker = thinkers[i];
+        const actionf_p1 function = thinker->function.p1;
+
+        if (function == T_PusherAdapter)
+        {
+            T_Pusher((pusher_t *)thinker);
+        }
+        else if (function == T_FrictionAdapter)
+        {
+            T_Friction((friction_t *)thinker);
+        }
+        else if (function)
+        {
+            function((mobj_t *)thinker);
+        }
+    }
+}
+
 /////////////////////////////
 //
 // P_GetPushThing() returns a pointer to an MT_PUSH or MT_PULL thing,
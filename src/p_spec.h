@@ -877,6 +877,9 @@ void T_GlowAdapter(struct mobj_s *mobj);
 
 void T_FireFlickerAdapter(struct mobj_s *mobj);  // killough 10/4/98
 
+// [Woof!] batches of consecutive thinkers, see P_RunThinkers()
+void T_RunLightBatch(thinker_t *const *thinkers, int count);
+
 // p_plats
 
 void T_PlatRaiseAdapter(struct mobj_s *mobj);
@@ -909,6 +912,10 @@ void T_PusherAdapter(struct mobj_s *mobj); // phares 3/20/98: Push thinker
 void T_ParamScrollFloorAdapter(struct mobj_s *mobj);
 void T_ParamScrollCeilingAdapter(struct mobj_s *mobj);
 
+// [Woof!] batches of consecutive thinkers, see P_RunThinkers()
+void T_RunScrollerBatch(thinker_t *const *thinkers, int count);
+void T_RunPusherBatch(thinker_t *const *thinkers, int count);
+
 ////////////////////////////////////////////////////////////////
 //
 // Linedef and sector special handler prototypes
@@ -1002,6 +1009,10 @@ void P_InitPicAnims(void);
 
 void P_InitSwitchList(void);
 
+// at level load, mark the textures that may replace the marked ones
+void P_MarkAnimatedTextures(byte *hitlist);
+void P_MarkSwitchTextures(byte *hitlist);
+
 // at map load
 void P_SpawnSpecials(void);
 
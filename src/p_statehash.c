@@ -0,0 +1,401 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Per-tic game state hashes for finding demo desyncs.
+//
+//      After every tic, the RNG, the players, the map objects and the
+//      sectors are hashed separately. The hashes are written to a file next
+//      to the demo. When the demo is played back later, the new hashes are
+//      compared against the file, and the first tic that differs is reported
+//      together with the parts of the game state that differ.
+//
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "d_player.h"
+#include "doomdef.h"
+#include "doomstat.h"
+#include "i_exit.h"
+#include "i_printf.h"
+#include "info.h"
+#include "m_argv.h"
+#include "m_io.h"
+#include "m_misc.h"
+#include "m_random.h"
+#include "p_mobj.h"
+#include "p_statehash.h"
+#include "p_tick.h"
+#include "r_defs.h"
+#include "r_state.h"
+
+#define HASH_MAGIC "WOOFSH1"
+
+typedef enum
+{
+    hash_rng,
+    hash_players,
+    hash_mobjs,
+    hash_sectors,
+    NUMHASHES
+} hash_part_t;
+
+static const char *part_names[NUMHASHES] = {
+    "RNG", "players", "map objects", "sectors"
+};
+
+typedef struct
+{
+    int episode, map, leveltime;
+    uint32_t hash[NUMHASHES];
+} hash_record_t;
+
+boolean statehash_enabled;
+
+static FILE *file;
+static char *filename;
+static boolean comparing, desynced;
+static int tic;
+
+static void Hash(uint32_t *hash, int32_t value)
+{
+    // FNV-1a over 32-bit words
+    *hash = (*hash ^ (uint32_t)value) * 16777619u;
+}
+
+static uint32_t HashRNG(void)
+{
+    uint32_t hash = 2166136261u;
+
+    for (int i = 0; i < NUMPRCLASS; ++i)
+    {
+        Hash(&hash, (int32_t)rng.seed[i]);
+    }
+    Hash(&hash, rng.rndindex);
+    Hash(&hash, rng.prndindex);
+
+    return hash;
+}
+
+static uint32_t HashPlayers(void)
+{
+    uint32_t hash = 2166136261u;
+
+    for (int i = 0; i < MAXPLAYERS; ++i)
+    {
+        const player_t *player = &players[i];
+
+        if (!playeringame[i])
+        {
+            continue;
+        }
+
+        Hash(&hash, player->playerstate);
+        Hash(&hash, player->health);
+        Hash(&hash, player->armorpoints);
+        Hash(&hash, player->armortype);
+        Hash(&hash, player->readyweapon);
+        Hash(&hash, player->pendingweapon);
+        Hash(&hash, player->killcount);
+        Hash(&hash, player->itemcount);
+        Hash(&hash, player->secretcount);
+        for (int j = 0; j < NUMAMMO; ++j)
+        {
+            Hash(&hash, player->ammo[j]);
+        }
+    }
+
+    return hash;
+}
+
+static uint32_t HashMobjs(void)
+{
+    uint32_t hash = 2166136261u;
+
+    for (thinker_t *th = thinkerkindcap[tk_mobj].knext;
+         th != &thinkerkindcap[tk_mobj]; th = th->knext)
+    {
+        const mobj_t *mo;
+
+        if (th->function.p1 != P_MobjThinker)
+        {
+            continue;
+        }
+
+        mo = (const mobj_t *)th;
+
+        Hash(&hash, mo->type);
+        Hash(&hash, mo->x);
+        Hash(&hash, mo->y);
+        Hash(&hash, mo->z);
+        Hash(&hash, mo->momx);
+        Hash(&hash, mo->momy);
+        Hash(&hash, mo->momz);
+        Hash(&hash, mo->angle);
+        Hash(&hash, mo->health);
+        Hash(&hash, mo->flags);
+        Hash(&hash, mo->state ? (int32_t)(mo->state - states) : -1);
+        Hash(&hash, mo->tics);
+        Hash(&hash, mo->movedir);
+        Hash(&hash, mo->movecount);
+        Hash(&hash, mo->reactiontime);
+        Hash(&hash, mo->threshold);
+    }
+
+    return hash;
+}
+
+static uint32_t HashSectors(void)
+{
+    uint32_t hash = 2166136261u;
+
+    for (int i = 0; i < numsectors; ++i)
+    {
+        const sector_t *sector = &sectors[i];
+
+        Hash(&hash, sector->floorheight);
+        Hash(&hash, sector->ceilingheight);
+        Hash(&hash, sector->lightlevel);
+        Hash(&hash, sector->special);
+    }
+
+    return hash;
+}
+
+static void Write32(uint32_t value)
+{
+    const byte data[4] = {value & 0xff, (value >> 8) & 0xff,
+                          (value >> 16) & 0xff, value >> 24};
+    fwrite(data, 1, sizeof(data), file);
+}
+
+static boolean Read32(uint32_t *value)
+{
+    byte data[4];
+
+    if (fread(data, 1, sizeof(data), file) != sizeof(data))
+    {
+        return false;
+    }
+
+    *value = data[0] | (data[1] << 8) | (data[2] << 16)
+             | ((uint32_t)data[3] << 24);
+    return true;
+}
+
+static boolean ReadRecord(hash_record_t *record)
+{
+    uint32_t values[3];
+
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!Read32(&values[i]))
+        {
+            return false;
+        }
+    }
+
+    record->episode = values[0];
+    record->map = values[1];
+    record->leveltime = values[2];
+
+    for (int i = 0; i < NUMHASHES; ++i)
+    {
+        if (!Read32(&record->hash[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void WriteRecord(const hash_record_t *record)
+{
+    Write32(record->episode);
+    Write32(record->map);
+    Write32(record->leveltime);
+
+    for (int i = 0; i < NUMHASHES; ++i)
+    {
+        Write32(record->hash[i]);
+    }
+}
+
+static void CompareRecord(const hash_record_t *record)
+{
+    hash_record_t expected;
+    char parts[64] = "";
+
+    if (!ReadRecord(&expected))
+    {
+        I_Printf(VB_WARNING,
+                 "P_UpdateStateHash: %s ends at tic %d, stop comparing.",
+                 filename, tic);
+        desynced = true;
+        return;
+    }
+
+    if (expected.episode != record->episode || expected.map != record->map
+        || expected.leveltime != record->leveltime)
+    {
+        M_StringConcat(parts, "level time", sizeof(parts));
+    }
+
+    for (int i = 0; i < NUMHASHES; ++i)
+    {
+        if (expected.hash[i] != record->hash[i])
+        {
+            if (parts[0])
+            {
+                M_StringConcat(parts, ", ", sizeof(parts));
+            }
+            M_StringConcat(parts, part_names[i], sizeof(parts));
+        }
+    }
+
+    if (parts[0])
+    {
+        I_Printf(VB_WARNING,
+                 "P_UpdateStateHash: Desync at tic %d (E%dM%d, level time "
+                 "%d), %s differ.",
+                 tic, record->episode, record->map, record->leveltime, parts);
+        desynced = true;
+    }
+}
+
+void P_UpdateStateHash(void)
+{
+    hash_record_t record;
+
+    if (!file || desynced)
+    {
+        return;
+    }
+
+    record.episode = gameepisode;
+    record.map = gamemap;
+    record.leveltime = leveltime;
+    record.hash[hash_rng] = HashRNG();
+    record.hash[hash_players] = HashPlayers();
+    record.hash[hash_mobjs] = HashMobjs();
+    record.hash[hash_sectors] = HashSectors();
+
+    if (comparing)
+    {
+        CompareRecord(&record);
+    }
+    else
+    {
+        WriteRecord(&record);
+    }
+
+    tic++;
+}
+
+void P_StartStateHash(const char *demo, boolean recording)
+{
+    static boolean first = true;
+    char magic[sizeof(HASH_MAGIC)];
+
+    //!
+    // @category demo
+    //
+    // Write a hash of the game state for every tic of a recorded demo to a
+    // .hash file next to it. With -playdemo, compare against that file and
+    // report the first tic that differs, or write it if it doesn't exist.
+    //
+
+    if (!M_ParmExists("-statehash"))
+    {
+        return;
+    }
+
+    if (first)
+    {
+        I_AtExit(P_StopStateHash, true);
+        first = false;
+    }
+
+    P_StopStateHash();
+
+    char *base = M_StringDuplicate(demo);
+    if (M_StringCaseEndsWith(base, ".lmp"))
+    {
+        base[strlen(base) - 4] = '\0';
+    }
+    filename = M_StringJoin(base, ".hash");
+    free(base);
+
+    comparing = !recording && M_FileExistsNotDir(filename);
+    file = M_fopen(filename, comparing ? "rb" : "wb");
+
+    if (!file)
+    {
+        I_Printf(VB_WARNING, "P_StartStateHash: Failed to open %s", filename);
+        free(filename);
+        filename = NULL;
+        return;
+    }
+
+    if (comparing)
+    {
+        if (fread(magic, 1, sizeof(magic), file) != sizeof(magic)
+            || memcmp(magic, HASH_MAGIC, sizeof(magic)))
+        {
+            I_Printf(VB_WARNING, "P_StartStateHash: Invalid file %s",
+                     filename);
+            P_StopStateHash();
+            return;
+        }
+    }
+    else
+    {
+        fwrite(HASH_MAGIC, 1, sizeof(HASH_MAGIC), file);
+    }
+
+    tic = 0;
+    desynced = false;
+    statehash_enabled = true;
+
+    I_Printf(VB_DEMO, "P_StartStateHash: %s %s", comparing ? "Comparing with"
+             : "Writing", filename);
+}
+
+void P_StopStateHash(void)
+{
+    if (!file)
+    {
+        return;
+    }
+
+    if (comparing && !desynced)
+    {
+        I_Printf(VB_ALWAYS, "P_StopStateHash: All %d tics match %s", tic,
+                 filename);
+    }
+    else if (!comparing)
+    {
+        I_Printf(VB_ALWAYS, "P_StopStateHash: %d tics written to %s", tic,
+                 filename);
+    }
+
+    fclose(file);
+    file = NULL;
+    free(filename);
+    filename = NULL;
+    statehash_enabled = false;
+}
@@ -0,0 +1,33 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Per-tic game state hashes for finding demo desyncs.
+//
+
+#ifndef __P_STATEHASH__
+#define __P_STATEHASH__
+
+#include "doomtype.h"
+
+extern boolean statehash_enabled;
+
+// Called when a demo starts recording or playing back.
+void P_StartStateHash(const char *demo, boolean recording);
+
+// Called after every tic.
+void P_UpdateStateHash(void);
+
+void P_StopStateHash(void);
+
+#endif
@@ -113,6 +113,18 @@ void P_InitSwitchList(void)
   Z_ChangeTag(alphSwitchList,PU_CACHE); //jff 3/23/98 allow table to be freed
 }
 
+// [Woof!] Marks both textures of every switch that has a marked texture.
+void P_MarkSwitchTextures(byte *hitlist)
+{
+  for (int i = 0; i < numswitches; i++)
+  {
+    const int on = switchlist[2 * i], off = switchlist[2 * i + 1];
+
+    if (hitlist[on] || hitlist[off])
+      hitlist[on] = hitlist[off] = 1;
+  }
+}
+
 //
 // P_StartButton()
 //
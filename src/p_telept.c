@@ -85,8 +85,8 @@ static mobj_t *P_TeleptFromSector(int i)
 
     sectors_telept[i].telept = NULL;
 
-    for (thinker_t *thinker = thinkercap.next; thinker != &thinkercap;
-         thinker = thinker->next)
+    for (thinker_t *thinker = thinkerkindcap[tk_mobj].knext;
+         thinker != &thinkerkindcap[tk_mobj]; thinker = thinker->knext)
     {
         mobj_t *m;
         if (thinker->function.p1 == P_MobjThinker
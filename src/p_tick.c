@@ -22,11 +22,14 @@
 #include "doomstat.h"
 #include "info.h"
 #include "m_arena.h"
+#include "m_array.h"
 #include "p_ambient.h"
 #include "p_map.h"
 #include "p_mobj.h"
+#include "p_profile.h"
 #include "p_tick.h"
 #include "p_spec.h"
+#include "p_statehash.h"
 #include "p_user.h"
 #include "s_musinfo.h"
 
@@ -49,10 +52,34 @@ thinker_t thinkercap = {0};
 
 thinker_t thinkerclasscap[NUMTHCLASS] = {0};
 
+thinker_t thinkerkindcap[NUMTHKINDS] = {0};
+
 int init_thinkers_count = 0;
 
 arena_t *thinkers_arena;
 
+//
+// [Woof!] Batches of effect thinkers
+//
+// Lights, scrollers and pushers are never removed, and new thinkers are only
+// added at the end of the list. So a run of consecutive effect thinkers of
+// the same kind stays consecutive, and P_RunThinkers() can call them from
+// one loop that dispatches directly instead of through the function pointer,
+// in the same order as before. The batches are rebuilt when effect thinkers
+// have been added.
+//
+
+typedef struct
+{
+  thinker_t *first, *last;
+  th_kind kind;
+  int start, count; // in batch_thinkers
+} thinkerbatch_t;
+
+static thinkerbatch_t *batches;
+static thinker_t **batch_thinkers;
+static boolean batches_dirty;
+
 //
 // P_InitThinkers
 //
@@ -66,9 +93,161 @@ void P_InitThinkers(void)
 
   thinkercap.prev = thinkercap.next  = &thinkercap;
 
+  for (i=0; i<NUMTHKINDS; i++)  // [Woof!]
+    thinkerkindcap[i].kprev = thinkerkindcap[i].knext = &thinkerkindcap[i];
+
+  batches_dirty = true;
+
   init_thinkers_count++;
 }
 
+//
+// [Woof!] Thinker kinds
+//
+
+static th_kind ThinkerKind(const thinker_t *thinker)
+{
+  const actionf_p1 f = thinker->function.p1;
+
+  if (f == P_MobjThinker || f == P_RemoveMobjThinkerDelayed)
+    return tk_mobj;
+
+  // ceilings and plats in stasis have no function
+  if (f == NULL ||
+      f == T_MoveCeilingAdapter || f == P_RemoveCeilingThinkerDelayed ||
+      f == T_VerticalDoorAdapter || f == P_RemoveDoorThinkerDelayed ||
+      f == T_MoveFloorAdapter || f == P_RemoveFloorThinkerDelayed ||
+      f == T_PlatRaiseAdapter || f == P_RemovePlatThinkerDelayed ||
+      f == T_MoveElevatorAdapter || f == P_RemoveElevatorThinkerDelayed)
+    return tk_mover;
+
+  if (f == T_LightFlashAdapter || f == T_StrobeFlashAdapter ||
+      f == T_GlowAdapter || f == T_FireFlickerAdapter)
+    return tk_light;
+
+  if (f == T_ScrollAdapter || f == T_ParamScrollFloorAdapter ||
+      f == T_ParamScrollCeilingAdapter)
+    return tk_scroller;
+
+  if (f == T_PusherAdapter || f == T_FrictionAdapter)
+    return tk_pusher;
+
+  if (f == T_AmbientSoundAdapter || f == P_RemoveAmbientThinkerDelayed)
+    return tk_ambient;
+
+  return tk_misc;
+}
+
+static boolean IsEffectKind(th_kind kind)
+{
+  return kind == tk_light || kind == tk_scroller || kind == tk_pusher;
+}
+
+static void AddToKind(thinker_t *thinker, th_kind kind)
+{
+  thinker_t *cap = &thinkerkindcap[kind];
+
+  if (IsEffectKind(kind))
+    batches_dirty = true;
+
+  cap->kprev->knext = thinker;
+  thinker->knext = cap;
+  thinker->kprev = cap->kprev;
+  cap->kprev = thinker;
+}
+
+thinker_t *P_ThinkerKind(th_kind kind)
+{
+  thinker_t *pending = &thinkerkindcap[tk_pending];
+
+  // Sort out the pending thinkers in order. Mobjs are never pending, so
+  // the order of their thread doesn't depend on when this happens.
+  if (kind != tk_mobj)
+  {
+    while (pending->knext != pending)
+    {
+      thinker_t *thinker = pending->knext;
+
+      (pending->knext = thinker->knext)->kprev = pending;
+      AddToKind(thinker, ThinkerKind(thinker));
+    }
+  }
+
+  return &thinkerkindcap[kind];
+}
+
+void P_RebuildThinkerKinds(void)
+{
+  thinker_t *th;
+  int i;
+
+  for (i=0; i<NUMTHKINDS; i++)
+    thinkerkindcap[i].kprev = thinkerkindcap[i].knext = &thinkerkindcap[i];
+
+  for (th = thinkercap.next; th != &thinkercap; th = th->next)
+    AddToKind(th, ThinkerKind(th));
+
+  batches_dirty = true;
+}
+
+static void UpdateBatches(void)
+{
+  thinkerbatch_t *batch = NULL;
+  thinker_t *th;
+
+  // sort out pending thinkers, may set batches_dirty
+  P_ThinkerKind(tk_pending);
+
+  if (!batches_dirty)
+    return;
+
+  batches_dirty = false;
+  array_clear(batches);
+  array_clear(batch_thinkers);
+
+  for (th = thinkercap.next; th != &thinkercap; th = th->next)
+  {
+    const th_kind kind = ThinkerKind(th);
+
+    if (!IsEffectKind(kind))
+    {
+      batch = NULL;
+      continue;
+    }
+
+    if (!batch || batch->kind != kind)
+    {
+      thinkerbatch_t new_batch = {th, th, kind, array_size(batch_thinkers), 0};
+      array_push(batches, new_batch);
+      batch = &batches[array_size(batches) - 1];
+    }
+
+    array_push(batch_thinkers, th);
+    batch->last = th;
+    batch->count++;
+  }
+}
+
+static void RunBatch(const thinkerbatch_t *batch)
+{
+  thinker_t *const *thinkers = &batch_thinkers[batch->start];
+
+  switch (batch->kind)
+  {
+    case tk_light:
+      T_RunLightBatch(thinkers, batch->count);
+      break;
+    case tk_scroller:
+      T_RunScrollerBatch(thinkers, batch->count);
+      break;
+    case tk_pusher:
+      T_RunPusherBatch(thinkers, batch->count);
+      break;
+    default:
+      break;
+  }
+}
+
 //
 // P_UpdateThinker
 //
@@ -126,6 +305,10 @@ void P_AddThinker(thinker_t* thinker)
   // killough 8/29/98: set sentinel pointers, and then add to appropriate list
   thinker->cnext = thinker->cprev = thinker;
   P_UpdateThinker(thinker);
+
+  // [Woof!] the function of most other thinkers isn't set yet
+  AddToKind(thinker, thinker->function.p1 == P_MobjThinker ? tk_mobj :
+                     tk_pending);
 }
 
 //
@@ -159,6 +342,9 @@ inline static void RemoveThinker(thinker_t *thinker)
     // haleyjd 6/17/08: remove from threaded list now
     (thinker->cnext->cprev = thinker->cprev)->cnext = thinker->cnext;
 
+    // [Woof!]
+    (thinker->knext->kprev = thinker->kprev)->knext = thinker->knext;
+
     arena_free(thinkers_arena, thinker);
 } 
 
@@ -318,11 +504,38 @@ void P_SetTarget(mobj_t **mop, mobj_t *targ)
 
 static void P_RunThinkers (void)
 {
+  const thinkerbatch_t *batch = NULL, *lastbatch = NULL;
+
+  // [Woof!] the profiler needs to see every thinker call
+  if (!playsim_profiling)
+  {
+    UpdateBatches();
+    batch = batches;
+    lastbatch = array_end(batches);
+  }
+
   for (currentthinker = thinkercap.next;
        currentthinker != &thinkercap;
        currentthinker = currentthinker->next)
-    if (currentthinker->function.p1)
-      currentthinker->function.p1((mobj_t *)currentthinker);
+    if (batch != lastbatch && currentthinker == batch->first)
+    {
+      // [Woof!] Effect thinkers don't add or remove thinkers.
+      RunBatch(batch);
+      currentthinker = batch->last;
+      batch++;
+    }
+    else if (currentthinker->function.p1)
+    {
+      // [Woof!] playsim profiler
+      if (playsim_profiling)
+      {
+        P_ProfileEnter(currentthinker->function.v, profile_thinker);
+        currentthinker->function.p1((mobj_t *)currentthinker);
+        P_ProfileLeave();
+      }
+      else
+        currentthinker->function.p1((mobj_t *)currentthinker);
+    }
 
   // [crispy] support MUSINFO lump (dynamic music changing)
   T_MusInfo();
@@ -347,7 +560,8 @@ static void P_FrozenTicker (void)
       if (playeringame[i])
         P_MobjThinker(players[i].mo);
 
-    for (th = thinkercap.next; th != &thinkercap; th = th->next)
+    for (th = thinkerkindcap[tk_mobj].knext; th != &thinkerkindcap[tk_mobj];
+         th = th->knext)
       if (th->function.p1 == P_MobjThinker)
       {
         mo = (mobj_t *) th;
@@ -388,12 +602,20 @@ void P_Ticker (void)
   }
   else
   {
+  P_InvalidateSightCache();
+
   P_MapStart();
   if (gamestate == GS_LEVEL)
   {
   for (i=0; i<MAXPLAYERS; i++)
     if (playeringame[i])
+    {
+      if (playsim_profiling)
+        P_ProfileEnter((actionf_v)P_PlayerThink, profile_thinker);
       P_PlayerThink(&players[i]);
+      if (playsim_profiling)
+        P_ProfileLeave();
+    }
   }
 
   P_RunThinkers();
@@ -403,6 +625,9 @@ void P_Ticker (void)
   }
 
   leveltime++;                       // for par times
+
+  if (statehash_enabled)
+    P_UpdateStateHash();
 }
 
 //----------------------------------------------------------------------------
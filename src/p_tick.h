@@ -70,6 +70,31 @@ typedef enum {
 
 extern thinker_t thinkerclasscap[];
 
+// [Woof!] threads of thinkers of the same kind, in thinker list order, for
+// searches that only need one kind. Mobjs are added right away, so their
+// thread can be walked directly. All other thinkers get their function
+// assigned after P_AddThinker(), they wait in the pending thread until
+// P_ThinkerKind() is called.
+typedef enum {
+   tk_pending,
+   tk_mobj,     // including mobjs pending removal
+   tk_mover,    // ceilings, doors, floors, plats and elevators
+   tk_light,
+   tk_scroller,
+   tk_pusher,   // pushers and friction
+   tk_ambient,
+   tk_misc,
+   NUMTHKINDS
+} th_kind;
+
+extern thinker_t thinkerkindcap[];
+
+// Returns the head of the thread for a kind.
+thinker_t *P_ThinkerKind(th_kind kind);
+
+// Called after thinkers have been restored without P_AddThinker().
+void P_RebuildThinkerKinds(void);
+
 extern int init_thinkers_count;
 
 extern arena_t *thinkers_arena;
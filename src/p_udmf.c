@@ -20,7 +20,9 @@
 #include "doomdef.h"
 #include "doomstat.h"
 #include "doomtype.h"
+#include "i_printf.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "m_arena.h"
 #include "m_argv.h"
 #include "m_array.h"
@@ -39,6 +41,9 @@
 #include "tables.h"
 #include "w_wad.h"
 #include <math.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
 
 //
 // Universal Doom Map Format (UDMF) support
@@ -210,104 +215,769 @@ void UDMF_ClearMemory(void)
     array_free(udmf_things);
 }
 
+//
+// UDMF scanner
+//
+// TEXTMAP lumps of large maps are tens of megabytes, so they are not run
+// through the generic scanner. Tokens point into the lump and are never
+// copied, and property names are looked up in a perfect hash table. The
+// tokens and values are the same as with the generic scanner.
+//
+
+typedef struct
+{
+    int token;          // TK_* or a character, TK_NoToken at the end
+    const char *string; // points into the lump, not terminated
+    int length;
+    int line, linepos;
+} udmf_token_t;
+
+typedef struct
+{
+    const char *pos, *end;
+    const char *linestart;
+    int line;
+    udmf_token_t token; // the last accepted token
+    udmf_token_t next;
+} udmf_scanner_t;
+
+static const char *const token_names[] = {
+    [TK_Identifier] = "Identifier",
+    [TK_StringConst] = "String Constant",
+    [TK_IntConst] = "Integer Constant",
+    [TK_BoolConst] = "Boolean Constant",
+    [TK_FloatConst] = "Float Constant",
+    [TK_AnnotateStart] = "Annotation Start",
+    [TK_AnnotateEnd] = "Annotation End",
+    [TK_ScopeResolution] = "Scope Resolution"
+};
+
+static NORETURN void UDMF_Error(udmf_scanner_t *s, const char *msg, ...)
+    PRINTF_ATTR(2, 3);
+
+static void UDMF_Error(udmf_scanner_t *s, const char *msg, ...)
+{
+    char buffer[1024];
+    va_list args;
+    va_start(args, msg);
+    M_vsnprintf(buffer, sizeof(buffer), msg, args);
+    va_end(args);
+
+    I_Error("TEXTMAP(%d:%d): %s", s->token.line, s->token.linepos + 1,
+            buffer);
+}
+
+static void SkipWhitespace(udmf_scanner_t *s)
+{
+    const char *p = s->pos;
+
+    while (p < s->end)
+    {
+        const char c = *p;
+
+        if (c == ' ' || c == '\t' || c == 0)
+        {
+            p++;
+        }
+        else if (c == '\n' || c == '\r')
+        {
+            p++;
+            // Windows style new line
+            if (c == '\r' && p < s->end && *p == '\n')
+            {
+                p++;
+            }
+            s->line++;
+            s->linestart = p;
+        }
+        else if (c == '/' && p + 1 < s->end && p[1] == '/')
+        {
+            while (p < s->end && *p != '\n' && *p != '\r')
+            {
+                p++;
+            }
+        }
+        else if (c == '/' && p + 1 < s->end && p[1] == '*')
+        {
+            p += 2;
+            while (p < s->end && !(*p == '*' && p + 1 < s->end && p[1] == '/'))
+            {
+                if (*p == '\n' || *p == '\r')
+                {
+                    p++;
+                    if (p[-1] == '\r' && p < s->end && *p == '\n')
+                    {
+                        p++;
+                    }
+                    s->line++;
+                    s->linestart = p;
+                }
+                else
+                {
+                    p++;
+                }
+            }
+            p += 2;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    s->pos = MIN(p, s->end);
+}
+
+inline static boolean IsIdentChar(char c)
+{
+    return c == '_' || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')
+           || (c >= '0' && c <= '9');
+}
+
+inline static boolean IsDigit(char c, int base)
+{
+    switch (base)
+    {
+        case 8:
+            return c >= '0' && c <= '7';
+        case 16:
+            return (c >= '0' && c <= '9') || (c >= 'A' && c <= 'F')
+                   || (c >= 'a' && c <= 'f');
+        default:
+            return c >= '0' && c <= '9';
+    }
+}
+
+// Same token boundaries as the generic scanner, quirks included.
+static const char *ScanNumber(const char *p, const char *end, int *token)
+{
+    const char *start = p;
+    boolean decimal = false, exponent = false;
+    int base = 10;
+
+    if (*p == '.')
+    {
+        decimal = true;
+        *token = TK_FloatConst;
+    }
+    else
+    {
+        base = (*p == '0') ? 8 : 10;
+        *token = TK_IntConst;
+    }
+    p++;
+
+    while (p < end)
+    {
+        const char c = *p;
+
+        if (*token == TK_IntConst)
+        {
+            if (c == '.' || (p - 1 != start && c == 'e'))
+            {
+                *token = TK_FloatConst;
+            }
+            else if ((c == 'x' || c == 'X') && p - 1 == start)
+            {
+                base = 16;
+                p++;
+                continue;
+            }
+            else if (IsDigit(c, base))
+            {
+                p++;
+                continue;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        if (c < '0' || c > '9')
+        {
+            if (!decimal && c == '.')
+            {
+                decimal = true;
+            }
+            else if (!exponent && c == 'e')
+            {
+                decimal = exponent = true;
+                if (p + 1 < end)
+                {
+                    const char next = p[1];
+                    if ((next < '0' || next > '9') && next != '+'
+                        && next != '-')
+                    {
+                        break;
+                    }
+                    p++;
+                }
+            }
+            else
+            {
+                break;
+            }
+        }
+        p++;
+    }
+
+    // Don't treat a lone '.' as a decimal.
+    if (*token == TK_FloatConst && p - start == 1 && decimal)
+    {
+        *token = '.';
+    }
+
+    return p;
+}
+
+static void ScanToken(udmf_scanner_t *s, udmf_token_t *t)
+{
+    SkipWhitespace(s);
+
+    const char *p = s->pos;
+    const char *end = s->end;
+
+    t->line = s->line;
+    t->linepos = (int)(p - s->linestart);
+    t->string = p;
+
+    if (p >= end)
+    {
+        t->token = TK_NoToken;
+        t->length = 0;
+        return;
+    }
+
+    const char c = *p;
+
+    if (c == '_' || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z'))
+    {
+        while (++p < end && IsIdentChar(*p))
+            ;
+        t->token = TK_Identifier;
+        t->length = (int)(p - t->string);
+
+        // Check for a boolean constant.
+        if ((t->length == 4 && !strncasecmp(t->string, "true", 4))
+            || (t->length == 5 && !strncasecmp(t->string, "false", 5)))
+        {
+            t->token = TK_BoolConst;
+        }
+    }
+    else if ((c >= '0' && c <= '9')
+             || (c == '.' && p + 1 < end && p[1] != '.'))
+    {
+        p = ScanNumber(p, end, &t->token);
+        t->length = (int)(p - t->string);
+    }
+    else if (c == '"')
+    {
+        t->string = ++p;
+        while (p < end && *p != '"')
+        {
+            p += (*p == '\\') ? 2 : 1;
+        }
+        t->token = TK_StringConst;
+        if (p < end)
+        {
+            t->length = (int)(p - t->string);
+            p++;
+        }
+        else
+        {
+            // unterminated, an empty string or a trailing backslash end the
+            // script
+            if (p > end || p == t->string)
+            {
+                t->token = TK_NoToken;
+            }
+            p = end;
+            t->length = (int)(p - t->string);
+        }
+    }
+    else
+    {
+        const char next = (p + 1 < end) ? p[1] : 0;
+
+        t->token = c;
+        if (c == ':' && next == ':')
+        {
+            t->token = TK_ScopeResolution;
+        }
+        else if (c == '/' && next == '*')
+        {
+            t->token = TK_AnnotateStart;
+        }
+        else if (c == '*' && next == '/')
+        {
+            t->token = TK_AnnotateEnd;
+        }
+        p += (t->token == c) ? 1 : 2;
+        t->length = (int)(p - t->string);
+    }
+
+    s->pos = p;
+}
+
+static void UDMF_OpenScanner(udmf_scanner_t *s, const char *data, int length)
+{
+    memset(s, 0, sizeof(*s));
+    s->pos = data;
+    s->end = data + length;
+    s->linestart = data;
+    s->line = 1;
+    ScanToken(s, &s->next);
+    s->token.line = s->next.line;
+    s->token.linepos = s->next.linepos;
+}
+
+inline static boolean UDMF_TokensLeft(udmf_scanner_t *s)
+{
+    return s->next.token != TK_NoToken;
+}
+
+inline static void UDMF_NextToken(udmf_scanner_t *s)
+{
+    s->token = s->next;
+    ScanToken(s, &s->next);
+}
+
+inline static boolean UDMF_CheckToken(udmf_scanner_t *s, int token)
+{
+    if (s->next.token == token
+        // An int can also be a float.
+        || (s->next.token == TK_IntConst && token == TK_FloatConst))
+    {
+        UDMF_NextToken(s);
+        return true;
+    }
+    return false;
+}
+
+static void UDMF_MustGetToken(udmf_scanner_t *s, int token)
+{
+    if (UDMF_CheckToken(s, token))
+    {
+        return;
+    }
+
+    UDMF_NextToken(s);
+    if (s->token.token == TK_NoToken)
+    {
+        UDMF_Error(s, "Unexpected end of script.");
+    }
+    else if (token < TK_NumSpecialTokens
+             && s->token.token < TK_NumSpecialTokens)
+    {
+        UDMF_Error(s, "Expected '%s' but got '%s' instead.",
+                   token_names[token], token_names[s->token.token]);
+    }
+    else if (token < TK_NumSpecialTokens)
+    {
+        UDMF_Error(s, "Expected '%s' but got '%c' instead.",
+                   token_names[token], s->token.token);
+    }
+    else if (s->token.token < TK_NumSpecialTokens)
+    {
+        UDMF_Error(s, "Expected '%c' but got '%s' instead.", token,
+                   token_names[s->token.token]);
+    }
+    else
+    {
+        UDMF_Error(s, "Expected '%c' but got '%c' instead.", token,
+                   s->token.token);
+    }
+}
+
+// Copies the unescaped string token, truncated to the buffer.
+static void UDMF_GetString(udmf_scanner_t *s, char *buffer, int size)
+{
+    const char *p = s->token.string;
+    const char *end = p + s->token.length;
+    int i = 0;
+
+    while (p < end && i < size - 1)
+    {
+        char c = *p++;
+
+        if (c == '\\')
+        {
+            if (p == end)
+            {
+                break; // trailing backslash
+            }
+            c = *p++;
+            switch (c)
+            {
+                case 'n':
+                    c = '\n';
+                    break;
+                case 'r':
+                    c = '\r';
+                    break;
+                case 't':
+                    c = '\t';
+                    break;
+                default:
+                    break;
+            }
+        }
+        buffer[i++] = c;
+    }
+    buffer[i] = '\0';
+}
+
+// Numbers that may not be exact in the fast paths go through the C library.
+#define MAX_NUMBER_LENGTH 64
+
+static int ParseInteger(const char *str, int length)
+{
+    const char *p = str, *end = str + length;
+    int base = 10;
+    int value = 0;
+
+    if (length > 9)
+    {
+        char buffer[MAX_NUMBER_LENGTH];
+        length = MIN(length, MAX_NUMBER_LENGTH - 1);
+        memcpy(buffer, str, length);
+        buffer[length] = '\0';
+        return strtol(buffer, NULL, (str[0] == '0') ? 0 : 10);
+    }
+
+    if (p[0] == '0')
+    {
+        base = 8;
+        if (length > 1 && (p[1] == 'x' || p[1] == 'X'))
+        {
+            base = 16;
+            p += 2;
+        }
+    }
+
+    for (; p < end && IsDigit(*p, base); p++)
+    {
+        const int c = *p;
+        value = value * base
+                + (c <= '9' ? c - '0' : (c | 0x20) - 'a' + 10);
+    }
+
+    return value;
+}
+
+static double ParseDecimal(const char *str, int length)
+{
+    static const double pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+        1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+        1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char *p = str, *end = str + length;
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+    {
+        mantissa = mantissa * 10 + (*p - '0');
+        digits += (mantissa != 0);
+    }
+
+    if (p < end && *p == '.')
+    {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            digits += (mantissa != 0);
+            exponent--;
+        }
+    }
+
+    if (p < end && *p == 'e')
+    {
+        const char *q = p + 1;
+        boolean negative = false;
+        int e = 0;
+
+        if (q < end && (*q == '+' || *q == '-'))
+        {
+            negative = (*q++ == '-');
+        }
+
+        if (q < end && *q >= '0' && *q <= '9')
+        {
+            for (; q < end && *q >= '0' && *q <= '9' && e < 1000; q++)
+            {
+                e = e * 10 + (*q - '0');
+            }
+            exponent += negative ? -e : e;
+            p = q;
+        }
+    }
+
+    // A mantissa of up to 15 digits and a power of ten up to 1e22 are exact
+    // doubles, so a single multiplication or division is correctly rounded,
+    // like atof().
+    if (p == end && digits <= 15 && exponent >= -22 && exponent <= 22)
+    {
+        return exponent < 0 ? (double)mantissa / pow10[-exponent]
+                            : (double)mantissa * pow10[exponent];
+    }
+
+    char buffer[MAX_NUMBER_LENGTH];
+    char *string = buffer;
+
+    if (length >= MAX_NUMBER_LENGTH)
+    {
+        string = malloc(length + 1);
+    }
+    memcpy(string, str, length);
+    string[length] = '\0';
+
+    const double result = atof(string);
+
+    if (string != buffer)
+    {
+        free(string);
+    }
+
+    return result;
+}
+
+//
+// UDMF property names
+//
+
+#define UDMF_KEYS(X)                                                         \
+    X(namespace) X(vertex) X(linedef) X(sidedef) X(sector) X(thing)          \
+    X(alpha) X(ambush) X(angle) X(arg0) X(arg1) X(arg2) X(arg3) X(arg4)      \
+    X(automapstyle) X(blocking) X(blocklandmonsters) X(blockmonsters)        \
+    X(blockplayers) X(blocksound) X(colormap) X(coop) X(dm) X(dontdraw)      \
+    X(dontpegbottom) X(dontpegtop) X(friend) X(height) X(heightceiling)      \
+    X(heightfloor) X(id) X(light) X(light_bottom) X(light_mid) X(light_top)  \
+    X(lightabsolute) X(lightabsolute_bottom) X(lightabsolute_mid)            \
+    X(lightabsolute_top) X(lightceiling) X(lightceilingabsolute)             \
+    X(lightfloor) X(lightfloorabsolute) X(lightlevel) X(mapped) X(midtex3d)  \
+    X(nofakecontrast) X(offsetx) X(offsetx_bottom) X(offsetx_mid)            \
+    X(offsetx_top) X(offsety) X(offsety_bottom) X(offsety_mid)               \
+    X(offsety_top) X(passuse) X(rotationceiling) X(rotationfloor)            \
+    X(scroll_ceil_type) X(scroll_ceil_x) X(scroll_ceil_y) X(scroll_floor_)   \
+    X(scroll_floor_type) X(scroll_floor_x) X(scrollceilingmode)              \
+    X(scrollfloormode) X(secret) X(sideback) X(sidefront) X(single)          \
+    X(skill1) X(skill2) X(skill3) X(skill4) X(skill5) X(smoothlighting)      \
+    X(special) X(texturebottom) X(textureceiling) X(texturefloor)            \
+    X(texturemiddle) X(texturetop) X(tint) X(tintceiling) X(tintfloor)       \
+    X(tranmap) X(twosided) X(type) X(v1) X(v2) X(x) X(xpanningceiling)       \
+    X(xpanningfloor) X(xscroll) X(xscrollbottom) X(xscrollceiling)           \
+    X(xscrollfloor) X(xscrollmid) X(xscrolltop) X(y) X(ypanningceiling)      \
+    X(ypanningfloor) X(yscroll) X(yscrollbottom) X(yscrollceiling)           \
+    X(yscrollfloor) X(yscrollmid) X(yscrolltop)
+
+#define UDMF_KEY_ENUM(name) UDMF_KEY_##name,
+#define UDMF_KEY_NAME(name) #name,
+
+typedef enum
+{
+    UDMF_KEY_NONE,
+    UDMF_KEYS(UDMF_KEY_ENUM)
+    NUM_UDMF_KEYS
+} udmf_key_t;
+
+static const char *const key_names[NUM_UDMF_KEYS] = {
+    NULL,
+    UDMF_KEYS(UDMF_KEY_NAME)
+};
+
+// Sparse enough that a collision-free seed is found after a few tries.
+#define KEY_TABLE_SIZE 4096
+
+static byte key_table[KEY_TABLE_SIZE];
+static uint32_t key_seed;
+static boolean key_table_ready;
+
+// FNV-1a of the lower case name
+inline static uint32_t HashKey(const char *str, int length, uint32_t seed)
+{
+    uint32_t hash = 2166136261u ^ seed;
+
+    for (int i = 0; i < length; i++)
+    {
+        const char c = str[i];
+        hash ^= (byte)((c >= 'A' && c <= 'Z') ? c | 0x20 : c);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static void InitKeyTable(void)
+{
+    for (key_seed = 0;; key_seed++)
+    {
+        boolean collision = false;
+
+        memset(key_table, 0, sizeof(key_table));
+
+        for (int key = 1; key < NUM_UDMF_KEYS && !collision; key++)
+        {
+            const char *name = key_names[key];
+            const uint32_t slot =
+                HashKey(name, strlen(name), key_seed) % KEY_TABLE_SIZE;
+
+            collision = (key_table[slot] != UDMF_KEY_NONE);
+            key_table[slot] = key;
+        }
+
+        if (!collision)
+        {
+            break;
+        }
+    }
+
+    key_table_ready = true;
+}
+
+// Property names are case-insensitive.
+static udmf_key_t UDMF_GetKey(udmf_scanner_t *s)
+{
+    UDMF_MustGetToken(s, TK_Identifier);
+
+    const char *str = s->token.string;
+    const int length = s->token.length;
+    const udmf_key_t key =
+        key_table[HashKey(str, length, key_seed) % KEY_TABLE_SIZE];
+    const char *name = key_names[key];
+
+    if (key == UDMF_KEY_NONE || strlen(name) != length)
+    {
+        return UDMF_KEY_NONE;
+    }
+
+    for (int i = 0; i < length; i++)
+    {
+        const char c = str[i];
+        if (((c >= 'A' && c <= 'Z') ? c | 0x20 : c) != name[i])
+        {
+            return UDMF_KEY_NONE;
+        }
+    }
+
+    return key;
+}
+
 //
 // UDMF parsing utils
 //
 
 // Retrieve plain integer
-inline static int UDMF_ScanInt(scanner_t *s)
+inline static int UDMF_ScanInt(udmf_scanner_t *s)
 {
     int x = 0;
-    SC_MustGetToken(s, '=');
-    x = SC_GetNegativeInteger(s);
-    SC_MustGetToken(s, ';');
-    return x;
+    UDMF_MustGetToken(s, '=');
+    const boolean neg = UDMF_CheckToken(s, '-');
+    UDMF_MustGetToken(s, TK_IntConst);
+    x = ParseInteger(s->token.string, s->token.length);
+    UDMF_MustGetToken(s, ';');
+    return neg ? -x : x;
 }
 
 // Retrieve plain double
-inline static double UDMF_ScanDouble(scanner_t *s)
+inline static double UDMF_ScanDouble(udmf_scanner_t *s)
 {
     double x = 0;
-    SC_MustGetToken(s, '=');
-    x = SC_GetNegativeDecimal(s);
-    SC_MustGetToken(s, ';');
-    return x;
+    UDMF_MustGetToken(s, '=');
+    const boolean neg = UDMF_CheckToken(s, '-');
+    UDMF_MustGetToken(s, TK_FloatConst);
+    if (s->token.token == TK_IntConst)
+    {
+        x = (double)ParseInteger(s->token.string, s->token.length);
+    }
+    else
+    {
+        x = ParseDecimal(s->token.string, s->token.length);
+    }
+    UDMF_MustGetToken(s, ';');
+    return neg ? -x : x;
 }
 
 // Sets provided flag on, if true
-inline static int UDMF_ScanFlag(scanner_t *s, int f)
+inline static int UDMF_ScanFlag(udmf_scanner_t *s, int f)
 {
     int x = 0;
-    SC_MustGetToken(s, '=');
-    SC_MustGetToken(s, TK_BoolConst);
-    if (SC_GetBoolean(s))
+    UDMF_MustGetToken(s, '=');
+    UDMF_MustGetToken(s, TK_BoolConst);
+    if (s->token.length == 4) // "true"
     {
         x |= f;
     }
-    SC_MustGetToken(s, ';');
+    UDMF_MustGetToken(s, ';');
     return x;
 }
 
 // Retrieve plain string
-inline static void UDMF_ScanLumpName(scanner_t *s, char *x)
+inline static void UDMF_ScanLumpName(udmf_scanner_t *s, char *x)
 {
-    SC_MustGetToken(s, '=');
-    SC_MustGetToken(s, TK_StringConst);
-    M_CopyLumpName(x, SC_GetString(s));
-    SC_MustGetToken(s, ';');
+    char buffer[9];
+    UDMF_MustGetToken(s, '=');
+    UDMF_MustGetToken(s, TK_StringConst);
+    UDMF_GetString(s, buffer, sizeof(buffer));
+    M_CopyLumpName(x, buffer);
+    UDMF_MustGetToken(s, ';');
 }
 
 // Property is valid in all namespaces
-#define BASE_PROP(keyword) (!strcmp(prop, #keyword))
+#define BASE_PROP(keyword) (prop == UDMF_KEY_##keyword)
 
 // Property is valid in the current namespace
 #define PROP(keyword, flags) \
-    ((udmf_flags & (flags)) && !strcmp(prop, #keyword))
+    ((udmf_flags & (flags)) && prop == UDMF_KEY_##keyword)
 
 // Parse specific string properties
-inline static int32_t UDMF_ScanSectorScroll(scanner_t *s)
+inline static int32_t UDMF_ScanSectorScroll(udmf_scanner_t *s)
 {
     int32_t mode = 0;
-    SC_MustGetToken(s, '=');
-    SC_MustGetToken(s, TK_StringConst);
-    const char *buf = SC_GetString(s);
-    M_StringToLower((char *)buf);
+    char buf[16];
+    UDMF_MustGetToken(s, '=');
+    UDMF_MustGetToken(s, TK_StringConst);
+    UDMF_GetString(s, buf, sizeof(buf));
+    M_StringToLower(buf);
     if (!strcmp(buf, "visual"))
       mode = SCROLL_TEXTURE;
     else if (!strcmp(buf, "physical"))
       mode = SCROLL_CARRY;
     else if (!strcmp(buf, "both"))
       mode = SCROLL_ALL;
-    SC_MustGetToken(s, ';');
+    UDMF_MustGetToken(s, ';');
     return mode;
 }
 
 // Skip unknown keyword
-static inline void UDMF_SkipScan(scanner_t *s)
+static inline void UDMF_SkipScan(udmf_scanner_t *s)
 {
-    if (SC_CheckToken(s, '='))
+    if (UDMF_CheckToken(s, '='))
     {
-        while (SC_TokensLeft(s))
+        while (UDMF_TokensLeft(s))
         {
-            if (SC_CheckToken(s, ';'))
+            if (UDMF_CheckToken(s, ';'))
             {
                 break;
             }
 
-            SC_GetNextToken(s, true);
+            UDMF_NextToken(s);
         }
         return;
     }
 
-    SC_MustGetToken(s, '{');
+    UDMF_MustGetToken(s, '{');
     int brace_count = 1;
-    while (SC_TokensLeft(s))
+    while (UDMF_TokensLeft(s))
     {
-        if (SC_CheckToken(s, '}'))
+        if (UDMF_CheckToken(s, '}'))
         {
             --brace_count;
         }
-        else if (SC_CheckToken(s, '{'))
+        else if (UDMF_CheckToken(s, '{'))
         {
             ++brace_count;
         }
@@ -315,16 +985,17 @@ static inline void UDMF_SkipScan(scanner_t *s)
         {
             break;
         }
-        SC_GetNextToken(s, true);
+        UDMF_NextToken(s);
     }
 }
 
 // UDMF namespace
-static void UDMF_ParseNamespace(scanner_t *s)
+static void UDMF_ParseNamespace(udmf_scanner_t *s)
 {
-    SC_MustGetToken(s, '=');
-    SC_MustGetToken(s, TK_StringConst);
-    const char *name = SC_GetString(s);
+    UDMF_MustGetToken(s, '=');
+    UDMF_MustGetToken(s, TK_StringConst);
+    char name[32];
+    UDMF_GetString(s, name, sizeof(name));
     udmf_flags = UDMF_BASE;
 
     if (!strcasecmp(name, "doom"))
@@ -343,23 +1014,21 @@ static void UDMF_ParseNamespace(scanner_t *s)
         I_Error("Unknown UDMF namespace: \"%s\".", name);
     }
 
-    SC_MustGetToken(s, ';');
+    UDMF_MustGetToken(s, ';');
 }
 
 //
 // UDMF vertex pasring
 //
 
-static void UDMF_ParseVertex(scanner_t *s)
+static void UDMF_ParseVertex(udmf_scanner_t *s)
 {
     UDMF_Vertex_t vertex = {0};
 
-    SC_MustGetToken(s, '{');
-    while (!SC_CheckToken(s, '}'))
+    UDMF_MustGetToken(s, '{');
+    while (!UDMF_CheckToken(s, '}'))
     {
-        SC_MustGetToken(s, TK_Identifier);
-        const char *prop = SC_GetString(s);
-        M_StringToLower((char *)prop);
+        const udmf_key_t prop = UDMF_GetKey(s);
         if (BASE_PROP(x))
         {
             vertex.x = UDMF_ScanDouble(s);
@@ -381,19 +1050,17 @@ static void UDMF_ParseVertex(scanner_t *s)
 // UDMF linedef loading
 //
 
-static void UDMF_ParseLinedef(scanner_t *s)
+static void UDMF_ParseLinedef(udmf_scanner_t *s)
 {
     UDMF_Linedef_t line = {0};
     line.sideback = -1;
     M_CopyLumpName(line.tranmap, "-");
     line.alpha = 1.0;
 
-    SC_MustGetToken(s, '{');
-    while (!SC_CheckToken(s, '}'))
+    UDMF_MustGetToken(s, '{');
+    while (!UDMF_CheckToken(s, '}'))
     {
-        SC_MustGetToken(s, TK_Identifier);
-        const char *prop = SC_GetString(s);
-        M_StringToLower((char *)prop);
+        const udmf_key_t prop = UDMF_GetKey(s);
         if (BASE_PROP(v1))
         {
             line.v1_id = UDMF_ScanInt(s);
@@ -515,7 +1182,7 @@ static void UDMF_ParseLinedef(scanner_t *s)
 // UDMF sidedef parsing
 //
 
-static void UDMF_ParseSidedef(scanner_t *s)
+static void UDMF_ParseSidedef(udmf_scanner_t *s)
 {
     UDMF_Sidedef_t side = {0};
     M_CopyLumpName(side.texturetop, "-");
@@ -523,12 +1190,10 @@ static void UDMF_ParseSidedef(scanner_t *s)
     M_CopyLumpName(side.texturebottom, "-");
     M_CopyLumpName(side.tint, "-");
 
-    SC_MustGetToken(s, '{');
-    while (!SC_CheckToken(s, '}'))
+    UDMF_MustGetToken(s, '{');
+    while (!UDMF_CheckToken(s, '}'))
     {
-        SC_MustGetToken(s, TK_Identifier);
-        const char *prop = SC_GetString(s);
-        M_StringToLower((char *)prop);
+        const udmf_key_t prop = UDMF_GetKey(s);
         if (BASE_PROP(offsetx))
         {
             side.offsetx = UDMF_ScanInt(s);
@@ -666,19 +1331,17 @@ static void UDMF_ParseSidedef(scanner_t *s)
 // UDMF sector parsing
 //
 
-static void UDMF_ParseSector(scanner_t *s)
+static void UDMF_ParseSector(udmf_scanner_t *s)
 {
     UDMF_Sector_t sector = {0};
     sector.lightlevel = 160;
     M_CopyLumpName(sector.texturefloor, "-");
     M_CopyLumpName(sector.textureceiling, "-");
 
-    SC_MustGetToken(s, '{');
-    while (!SC_CheckToken(s, '}'))
+    UDMF_MustGetToken(s, '{');
+    while (!UDMF_CheckToken(s, '}'))
     {
-        SC_MustGetToken(s, TK_Identifier);
-        const char *prop = SC_GetString(s);
-        M_StringToLower((char *)prop);
+        const udmf_key_t prop = UDMF_GetKey(s);
         if (BASE_PROP(heightfloor))
         {
             sector.heightfloor = UDMF_ScanInt(s);
@@ -824,7 +1487,7 @@ static void UDMF_ParseSector(scanner_t *s)
 // UDMF thing loading
 //
 
-static void UDMF_ParseThing(scanner_t *s)
+static void UDMF_ParseThing(udmf_scanner_t *s)
 {
     UDMF_Thing_t thing = {0};
     thing.options |= MTF_NOTSINGLE | MTF_NOTCOOP | MTF_NOTDM;
@@ -832,12 +1495,10 @@ static void UDMF_ParseThing(scanner_t *s)
     thing.alpha = 1.0;
     thing.health = 1.0;
 
-    SC_MustGetToken(s, '{');
-    while (!SC_CheckToken(s, '}'))
+    UDMF_MustGetToken(s, '{');
+    while (!UDMF_CheckToken(s, '}'))
     {
-        SC_MustGetToken(s, TK_Identifier);
-        const char *prop = SC_GetString(s);
-        M_StringToLower((char *)prop);
+        const udmf_key_t prop = UDMF_GetKey(s);
         if (BASE_PROP(type))
         {
             thing.type = UDMF_ScanInt(s);
@@ -955,44 +1616,37 @@ static void UDMF_ParseThing(scanner_t *s)
 // UDMF textmap loading
 //
 
-static void UDMF_ParseTextMap(map_t *map)
+static void UDMF_ParseTextMapData(const char *data, int length)
 {
-    scanner_t *s = SC_Open("TEXTMAP", W_CacheLumpNum(map->textmap, PU_CACHE),
-                           W_LumpLength(map->textmap));
+    udmf_scanner_t scanner, *s = &scanner;
 
-    while (SC_TokensLeft(s))
-    {
-        SC_MustGetToken(s, TK_Identifier);
-        const char *toplevel = SC_GetString(s);
-        M_StringToLower((char *)toplevel);
+    UDMF_OpenScanner(s, data, length);
 
-        if (!strcmp(toplevel, "namespace"))
-        {
-            UDMF_ParseNamespace(s);
-        }
-        else if (!strcmp(toplevel, "vertex"))
-        {
-            UDMF_ParseVertex(s);
-        }
-        else if (!strcmp(toplevel, "linedef"))
-        {
-            UDMF_ParseLinedef(s);
-        }
-        else if (!strcmp(toplevel, "sidedef"))
-        {
-            UDMF_ParseSidedef(s);
-        }
-        else if (!strcmp(toplevel, "sector"))
-        {
-            UDMF_ParseSector(s);
-        }
-        else if (!strcmp(toplevel, "thing"))
-        {
-            UDMF_ParseThing(s);
-        }
-        else
+    while (UDMF_TokensLeft(s))
+    {
+        switch (UDMF_GetKey(s))
         {
-            UDMF_SkipScan(s);
+            case UDMF_KEY_namespace:
+                UDMF_ParseNamespace(s);
+                break;
+            case UDMF_KEY_vertex:
+                UDMF_ParseVertex(s);
+                break;
+            case UDMF_KEY_linedef:
+                UDMF_ParseLinedef(s);
+                break;
+            case UDMF_KEY_sidedef:
+                UDMF_ParseSidedef(s);
+                break;
+            case UDMF_KEY_sector:
+                UDMF_ParseSector(s);
+                break;
+            case UDMF_KEY_thing:
+                UDMF_ParseThing(s);
+                break;
+            default:
+                UDMF_SkipScan(s);
+                break;
         }
     }
 
@@ -1000,10 +1654,62 @@ static void UDMF_ParseTextMap(map_t *map)
         || array_size(udmf_sidedefs) == 0 || array_size(udmf_sectors) == 0
         || array_size(udmf_things) == 0)
     {
-        SC_Error(s, "Not enough UDMF data. Check your TEXTMAP.");
+        UDMF_Error(s, "Not enough UDMF data. Check your TEXTMAP.");
     }
+}
+
+static double Throughput(int length, uint64_t time)
+{
+    return time ? length / (time / 1000000000.0) / (1024 * 1024) : 0.0;
+}
+
+static void UDMF_ParseTextMap(map_t *map)
+{
+    const char *data = W_CacheLumpNum(map->textmap, PU_CACHE);
+    const int length = W_LumpLength(map->textmap);
+    uint64_t start;
+
+    if (!key_table_ready)
+    {
+        InitKeyTable();
+    }
+
+    //!
+    // @category obscure
+    // @arg <n>
+    //
+    // Parse the TEXTMAP of UDMF maps n extra times and print the parser
+    // throughput.
+    //
+
+    int p = M_CheckParmWithArgs("-udmfbench", 1);
+
+    if (p)
+    {
+        const int runs = MAX(atoi(myargv[p + 1]), 1);
+
+        start = I_GetTimeNS();
+        for (int i = 0; i < runs; i++)
+        {
+            UDMF_ClearMemory();
+            UDMF_ParseTextMapData(data, length);
+        }
+        const uint64_t time = (I_GetTimeNS() - start) / runs;
+
+        I_Printf(VB_ALWAYS,
+                 "UDMF_ParseTextMap: %s, %d KiB, %.3f ms per run, %.1f MB/s",
+                 lumpinfo[map->label].name, length / 1024, time / 1000000.0,
+                 Throughput(length, time));
+
+        UDMF_ClearMemory();
+    }
+
+    start = I_GetTimeNS();
+    UDMF_ParseTextMapData(data, length);
+    const uint64_t time = I_GetTimeNS() - start;
 
-    SC_Close(s);
+    I_Printf(VB_DEBUG, "UDMF_ParseTextMap: %d KiB in %.2f ms (%.1f MB/s)",
+             length / 1024, time / 1000000.0, Throughput(length, time));
 }
 
 static void UDMF_LoadVertexes(void)
@@ -1367,7 +2073,5 @@ void UDMF_LoadMap(map_t *map)
     UDMF_LoadSideDefs_Post(); // <- this needs side_t::special
     UDMF_LoadLineDefs_Post(); // <- this needs Sides Post Processing
 
-    map->bmap_format = P_LoadBlockMap(map->blockmap);
-    P_LoadBSPTree_ZDBSP(map->znodes, map->bsp_format);
-    map->reject_built = P_LoadReject(map->reject, P_GroupLines());
+    // [Woof!] The blockmap, nodes and REJECT are loaded by P_SetupLevel().
 }
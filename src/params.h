@@ -42,6 +42,7 @@ static const char *params[] = {
 "-solo-net",
 "-blockmap",
 "-bsp",
+"-buildreject",
 "-force_old_zdoom_nodes",
 "-noautoload",
 "-nocheats",
@@ -49,12 +50,17 @@ static const char *params[] = {
 "-noextras",
 "-nomapinfo",
 "-nooptions",
+"-noparsecache",
 "-reject_pad_with_ff",
 "-tranmap",
 "-levelstat",
 "-longtics",
 "-shorttics",
 "-tas",
+"-statehash",
+"-deduplumps",
+"-lumpbench",
+"-profileplaysim",
 "-nogui",
 };
 
@@ -89,12 +95,17 @@ static const char *params_with_args[] = {
 "-recordfromto",
 "-skipsec",
 "-timedemo",
+"-demolist",
+"-demojobs",
 "-cl",
 "-complevel",
 "-gameversion",
 "-setmem",
 "-spechit",
 "-statdump",
+"-startuptrace",
+"-udmfbench",
+"-interceptbench",
 };
 
 #define HELP_STRING "Usage: woof [options] \n\
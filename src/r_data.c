@@ -30,12 +30,15 @@
 #include "doomtype.h"
 #include "i_printf.h"
 #include "i_system.h"
+#include "i_thread.h"
 #include "info.h"
 #include "m_array.h"
 #include "m_fixed.h"
 #include "m_misc.h"
 #include "m_swap.h"
+#include "m_trace.h"
 #include "p_mobj.h"
+#include "p_spec.h"
 #include "p_tick.h"
 #include "r_bmaps.h" // [crispy] R_BrightmapForTexName()
 #include "r_defs.h"
@@ -228,7 +231,28 @@ static void R_DrawColumnInCache(const column_t *patch, byte *cache,
 //
 // Rewritten by Lee Killough for performance and to fix Medusa bug
 
-static void R_GenerateComposite(int texnum)
+// [Woof!] Split into the allocation of the composite blocks, which has to
+// happen on the main thread, and the drawing, which is thread-safe as long
+// as the patches have been cached before.
+
+static void R_AllocComposite(int texnum)
+{
+  const texture_t *texture = textures[texnum];
+
+  if (!texturecomposite[texnum])
+  {
+    Z_Malloc(texturecompositesize[texnum], PU_LEVEL,
+             (void **) &texturecomposite[texnum]);
+  }
+  // [FG] memory block for opaque textures
+  if (!texturecomposite2[texnum])
+  {
+    Z_Malloc(texture->width * texture->height, PU_LEVEL,
+             (void **) &texturecomposite2[texnum]);
+  }
+}
+
+static void R_DrawComposite(int texnum, patch_t *const *patches)
 {
   byte *block = texturecomposite[texnum],
        *block2 = texturecomposite2[texnum];
@@ -240,26 +264,15 @@ static void R_GenerateComposite(int texnum)
   unsigned *colofs2 = texturecolumnofs2[texnum];
   int i = texture->patchcount;
   // killough 4/9/98: marks to identify transparent regions in merged textures
-  byte *marks = Z_Calloc(texture->width * texture->height, sizeof(*marks), PU_STATIC, 0),
+  byte *marks = calloc(texture->width * texture->height, sizeof(*marks)),
        *source;
 
-  if (!block)
-  {
-    block = Z_Malloc(texturecompositesize[texnum], PU_LEVEL,
-                     (void **) &texturecomposite[texnum]);
-  }
-  // [FG] memory block for opaque textures
-  if (!block2)
-  {
-    block2 = Z_Malloc(texture->width * texture->height, PU_LEVEL,
-                      (void **) &texturecomposite2[texnum]);
-  }
   // [FG] initialize composite background to palette index 0 (usually black)
   memset(block, 0, texturecompositesize[texnum]);
 
   for (; --i >=0; patch++)
     {
-      patch_t *realpatch = V_CachePatchNum(patch->patch, PU_CACHE);
+      const patch_t *realpatch = *patches++;
       int x, x1 = patch->originx, x2 = x1 + SHORT(realpatch->width);
       const int *cofs = realpatch->columnofs - x1;
 
@@ -281,7 +294,7 @@ static void R_GenerateComposite(int texnum)
   // killough 4/9/98: Next, convert multipatched columns into true columns,
   // to fix Medusa bug while still allowing for transparent regions.
 
-  source = Z_Malloc(texture->height, PU_STATIC, 0);       // temporary column
+  source = malloc(texture->height);       // temporary column
   for (i=0; i < texture->width; i++)
     // [FG] generate composites for all columns
 //  if (collump[i] == -1)                 // process only multipatched columns
@@ -334,8 +347,26 @@ static void R_GenerateComposite(int texnum)
             col = (column_t *)((byte *) col + len + 4); // next post
           }
       }
-  Z_Free(source);         // free temporary column
-  Z_Free(marks);          // free transparency marks
+  free(source);         // free temporary column
+  free(marks);          // free transparency marks
+}
+
+static void R_GenerateComposite(int texnum)
+{
+  const texture_t *texture = textures[texnum];
+  patch_t **patches = malloc(texture->patchcount * sizeof(*patches));
+
+  I_Printf(VB_DEBUG, "R_GenerateComposite: %.8s generated on demand",
+           texture->name);
+
+  R_AllocComposite(texnum);
+
+  for (int i = 0; i < texture->patchcount; i++)
+    patches[i] = V_CachePatchNum(texture->patches[i].patch, PU_CACHE);
+
+  R_DrawComposite(texnum, patches);
+
+  free(patches);
 }
 
 //
@@ -344,7 +375,18 @@ static void R_GenerateComposite(int texnum)
 // Rewritten by Lee Killough for performance and to fix Medusa bug
 //
 
-static void R_GenerateLookup(int texnum, int *const errors)
+// [Woof!] Messages are collected in the lookup info and printed later in
+// texture order, since this runs on worker threads.
+
+typedef struct
+{
+  int badcol;   // first bad column, or -1
+  int *nopatch; // columns without a patch, in descending order
+  boolean err;
+} lookupinfo_t;
+
+static void R_GenerateLookup(int texnum, patch_t *const *patches,
+                             lookupinfo_t *info)
 {
   const texture_t *texture = textures[texnum];
 
@@ -359,17 +401,19 @@ static void R_GenerateLookup(int texnum, int *const errors)
 
   struct {
     unsigned patches, posts;
-  } *count = Z_Calloc(texture->width, sizeof(*count), PU_STATIC, 0);
+  } *count = calloc(texture->width, sizeof(*count));
 
   // killough 12/98: First count the number of patches per column.
 
   const texpatch_t *patch = texture->patches;
   int i = texture->patchcount;
 
+  info->badcol = -1;
+
   while (--i >= 0)
     {
       int pat = patch->patch;
-      const patch_t *realpatch = V_CachePatchNum(pat, PU_CACHE);
+      const patch_t *realpatch = patches[texture->patchcount - 1 - i];
       int x, x1 = patch++->originx, x2 = x1 + SHORT(realpatch->width);
       const int *cofs = realpatch->columnofs - x1;
       
@@ -406,8 +450,7 @@ static void R_GenerateLookup(int texnum, int *const errors)
 
       for (i = texture->patchcount, patch = texture->patches; --i >= 0;)
 	{
-	  int pat = patch->patch;
-	  const patch_t *realpatch = V_CachePatchNum(pat, PU_CACHE);
+	  const patch_t *realpatch = patches[texture->patchcount - 1 - i];
 	  int x, x1 = patch++->originx, x2 = x1 + SHORT(realpatch->width);
 	  const int *cofs = realpatch->columnofs - x1;
 	  
@@ -433,10 +476,7 @@ static void R_GenerateLookup(int texnum, int *const errors)
 		      if (badcol)
 			{
 			  badcol = 0;
-			  I_Printf(VB_DEBUG, "Warning: Texture %8.8s "
-				 "(height %d) has bad column(s)"
-				 " starting at x = %d.",
-				 texture->name, texture->height, x);
+			  info->badcol = x;
 			}
 		      break;
 		    }
@@ -464,9 +504,7 @@ static void R_GenerateLookup(int texnum, int *const errors)
 //	  if (devparm)
 	    {
 	      // killough 8/8/98
-	      I_Printf(VB_DEBUG, "R_GenerateLookup:"
-		     " Column %d is without a patch in texture %.8s",
-		     x, texture->name);
+	      array_push(info->nopatch, x);
 //	      ++*errors;
 	    }
 //	  else
@@ -498,14 +536,221 @@ static void R_GenerateLookup(int texnum, int *const errors)
 
     texturecompositesize[texnum] = csize;
     
-    if (err)       // killough 10/98: non-verbose output
+    info->err = err;       // killough 10/98: non-verbose output
+  }
+  free(count);                    // killough 4/9/98
+}
+
+// [Woof!] Reports the lookup of a texture, in the order of the original.
+static void R_ReportLookup(int texnum, lookupinfo_t *info, int *const errors)
+{
+  const texture_t *texture = textures[texnum];
+  int *x;
+
+  if (info->badcol >= 0)
+    I_Printf(VB_DEBUG, "Warning: Texture %8.8s "
+             "(height %d) has bad column(s)"
+             " starting at x = %d.",
+             texture->name, texture->height, info->badcol);
+
+  array_foreach(x, info->nopatch)
+    I_Printf(VB_DEBUG, "R_GenerateLookup:"
+             " Column %d is without a patch in texture %.8s",
+             *x, texture->name);
+
+  if (info->err)
+    {
+      I_Printf(VB_WARNING, "R_GenerateLookup: Column without a patch in texture %.8s",
+             texture->name);
+      ++*errors;
+    }
+
+  array_free(info->nopatch);
+}
+
+//
+// [Woof!] Texture batches
+//
+// Lookups and composites are generated on worker threads. Neither the zone
+// nor the WAD code is thread-safe, so the patches of a batch are cached on
+// the main thread before and locked until all of its jobs have finished.
+// Batches keep the amount of locked patch data bounded.
+//
+
+#define TEXTURE_BATCH 512
+
+typedef struct
+{
+  const int *texnums;
+  int count;
+  patch_t **patches;   // of all textures of the batch, in order
+  int *firstpatch;     // index into patches for each texture
+  lookupinfo_t *info;  // indexed by texture number
+} texbatch_t;
+
+typedef struct
+{
+  int first, last;
+} texjob_t;
+
+static texbatch_t batch;
+
+static void LockBatch(void)
+{
+  array_clear(batch.patches);
+  array_clear(batch.firstpatch);
+
+  for (int i = 0; i < batch.count; i++)
+  {
+    const texture_t *texture = textures[batch.texnums[i]];
+
+    array_push(batch.firstpatch, array_size(batch.patches));
+
+    for (int j = 0; j < texture->patchcount; j++)
+      array_push(batch.patches,
+                 V_CachePatchNum(texture->patches[j].patch, PU_STATIC));
+  }
+}
+
+static void UnlockBatch(void)
+{
+  for (int i = 0; i < batch.count; i++)
+  {
+    const texture_t *texture = textures[batch.texnums[i]];
+
+    for (int j = 0; j < texture->patchcount; j++)
+      V_CachePatchNum(texture->patches[j].patch, PU_CACHE);
+  }
+}
+
+static void LookupJob(void *data)
+{
+  const texjob_t *job = data;
+
+  for (int i = job->first; i < job->last; i++)
+  {
+    const int texnum = batch.texnums[i];
+    R_GenerateLookup(texnum, batch.patches + batch.firstpatch[i],
+                     &batch.info[texnum]);
+  }
+}
+
+static void CompositeJob(void *data)
+{
+  const texjob_t *job = data;
+
+  for (int i = job->first; i < job->last; i++)
+    R_DrawComposite(batch.texnums[i], batch.patches + batch.firstpatch[i]);
+}
+
+static void RunTextureJobs(const int *texnums, int count, jobfunc_t func)
+{
+  const int num_workers = I_NumWorkerThreads();
+  texjob_t *jobs = NULL;
+
+  for (int start = 0; start < count; start += TEXTURE_BATCH)
+  {
+    batch.texnums = texnums + start;
+    batch.count = MIN(count - start, TEXTURE_BATCH);
+
+    LockBatch();
+
+    const int num_jobs = num_workers ? MIN(batch.count, (num_workers + 1) * 4) : 1;
+
+    if (num_jobs == 1)
+    {
+      texjob_t job = {0, batch.count};
+      func(&job);
+    }
+    else
+    {
+      jobgroup_t *group = I_CreateJobGroup();
+
+      array_resize(jobs, num_jobs);
+
+      for (int i = 0; i < num_jobs; i++)
       {
-	I_Printf(VB_WARNING, "R_GenerateLookup: Column without a patch in texture %.8s",
-	       texture->name);
-	++*errors;
+        jobs[i].first = batch.count * i / num_jobs;
+        jobs[i].last = batch.count * (i + 1) / num_jobs;
+        I_AddJob(group, func, &jobs[i]);
       }
+
+      I_WaitJobGroup(group);
+    }
+
+    UnlockBatch();
   }
-  Z_Free(count);                    // killough 4/9/98
+
+  array_free(jobs);
+  array_free(batch.patches);
+  array_free(batch.firstpatch);
+  batch.texnums = NULL;
+  batch.count = 0;
+}
+
+static void R_GenerateLookups(int *const errors)
+{
+  int *texnums = NULL;
+
+  for (int i = 0; i < numtextures; i++)
+    array_push(texnums, i);
+
+  batch.info = calloc(numtextures, sizeof(*batch.info));
+
+  RunTextureJobs(texnums, numtextures, LookupJob);
+
+  for (int i = 0; i < numtextures; i++)
+    R_ReportLookup(i, &batch.info[i], errors);
+
+  free(batch.info);
+  batch.info = NULL;
+  array_free(texnums);
+}
+
+//
+// R_GenerateLevelComposites
+//
+// [Woof!] Generate the composites of all textures that the level may show,
+// so that R_GetColumn() doesn't have to while rendering.
+//
+
+void R_GenerateLevelComposites(void)
+{
+  byte *hitlist = calloc(numtextures, sizeof(*hitlist));
+  int *texnums = NULL;
+  sky_t *sky;
+
+  for (int i = 0; i < numsides; i++)
+    hitlist[sides[i].bottomtexture] =
+      hitlist[sides[i].toptexture] =
+      hitlist[sides[i].midtexture] = 1;
+
+  array_foreach(sky, levelskies)
+  {
+    hitlist[sky->background.texture] = 1;
+    if (sky->type == SkyType_WithForeground)
+      hitlist[sky->foreground.texture] = 1;
+  }
+
+  P_MarkAnimatedTextures(hitlist);
+  P_MarkSwitchTextures(hitlist);
+
+  for (int i = 0; i < numtextures; i++)
+  {
+    if (hitlist[i] && (!texturecomposite[i] || !texturecomposite2[i]))
+    {
+      R_AllocComposite(i);
+      array_push(texnums, i);
+    }
+  }
+
+  RunTextureJobs(texnums, array_size(texnums), CompositeJob);
+
+  I_Printf(VB_DEBUG, "R_GenerateLevelComposites: %d composites generated",
+           array_size(texnums));
+
+  array_free(texnums);
+  free(hitlist);
 }
 
 //
@@ -821,8 +1066,7 @@ void R_InitTextures (void)
     I_Error("\n\n%d errors.", errors);
     
   // Precalculate whatever possible.
-  for (i=0 ; i<numtextures ; i++)
-    R_GenerateLookup(i, &errors);
+  R_GenerateLookups(&errors);
 
   if (errors)
     I_Error("\n\n%d errors.", errors);
@@ -995,13 +1239,27 @@ void R_InitData(void)
   // which are required by R_InitTextures() to prevent flat lumps from being
   // mistaken as patches and by R_InitFlatBrightmaps() to set brightmaps for
   // flats.
+  M_TraceBegin("R_InitFlats");
   R_InitFlats();
+  M_TraceEnd();
+  M_TraceBegin("R_ParseBrightmaps");
   W_ProcessInWads("BRGHTMPS", R_ParseBrightmaps, PROCESS_PWAD);
+  M_TraceEnd();
+  M_TraceBegin("R_InitTextures");
   R_InitTextures();
+  M_TraceEnd();
+  M_TraceBegin("R_InitSpriteLumps");
   R_InitSpriteLumps();
+  M_TraceEnd();
+  M_TraceBegin("R_InitTranMap");
   R_InitTranMap();                      // killough 2/21/98, 3/6/98
+  M_TraceEnd();
+  M_TraceBegin("R_InitColormaps");
   R_InitColormaps();                    // killough 3/20/98
+  M_TraceEnd();
+  M_TraceBegin("R_InitSkyDefs");
   R_InitSkyDefs();
+  M_TraceEnd();
 }
 
 //
@@ -1156,7 +1414,8 @@ void R_PrecacheLevel(void)
 
   {
     thinker_t *th;
-    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    for (th = thinkerkindcap[tk_mobj].knext ; th != &thinkerkindcap[tk_mobj] ;
+         th=th->knext)
       if (th->function.p1 == P_MobjThinker)
         hitlist[((mobj_t *)th)->sprite] = 1;
   }
@@ -53,6 +53,9 @@ byte *R_GetColumnMasked(int tex, int col);
 void R_InitData (void);
 void R_PrecacheLevel (void);
 
+// Generate the composites of the level's textures up front.
+void R_GenerateLevelComposites(void);
+
 // Retrieval.
 // Floor/ceiling opaque texture tiles,
 // lookup by name. For animation?
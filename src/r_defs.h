@@ -367,6 +367,17 @@ typedef struct ssline_s
   fixed_t bbox[4];
 } ssline_t;
 
+// [Woof!] The fields of line_t that are read for every line checked against
+// a bounding box, packed into an array parallel to lines[].
+
+typedef struct linebox_s
+{
+  fixed_t bbox[4];
+  fixed_t x, y;          // v1
+  fixed_t dx, dy;
+  slopetype_t slopetype;
+} linebox_t;
+
 //
 // A SubSector.
 // References a Sector.
@@ -48,6 +48,7 @@
 #include "r_things.h"
 #include "r_voxel.h"
 #include "m_config.h"
+#include "m_trace.h"
 #include "st_stuff.h"
 #include "v_flextran.h"
 #include "v_video.h"
@@ -253,7 +254,7 @@ angle_t R_PointToAngle2(fixed_t viewx, fixed_t viewy, fixed_t x, fixed_t y)
 // [FG] overflow-safe R_PointToAngle() flavor,
 // only used in R_CheckBBox(), R_AddLine() and P_SegLengths()
 
-angle_t R_PointToAngleCrispy(fixed_t x, fixed_t y)
+angle_t R_PointToAngle2Crispy(fixed_t viewx, fixed_t viewy, fixed_t x, fixed_t y)
 {
   // [FG] fix overflows for very long distances
   int64_t y_viewy = (int64_t)y - viewy;
@@ -281,6 +282,11 @@ angle_t R_PointToAngleCrispy(fixed_t x, fixed_t y)
     0;
 }
 
+angle_t R_PointToAngleCrispy(fixed_t x, fixed_t y)
+{
+  return R_PointToAngle2Crispy(viewx, viewy, x, y);
+}
+
 // WiggleFix: move R_ScaleFromGlobalAngle to r_segs.c,
 // above R_StoreWallRange
 
@@ -627,12 +633,20 @@ void R_ExecuteSetViewSize (void)
 
 void R_Init (void)
 {
+  M_TraceBegin("R_InitData");
   R_InitData();
+  M_TraceEnd();
   R_SetViewSize(screenblocks);
   R_InitPlanes();
+  M_TraceBegin("R_InitLightTables");
   R_InitLightTables();
+  M_TraceEnd();
+  M_TraceBegin("R_InitTranslationTables");
   R_InitTranslationTables();
+  M_TraceEnd();
+  M_TraceBegin("V_InitFlexTranTable");
   V_InitFlexTranTable();
+  M_TraceEnd();
 
   // [FG] spectre drawing mode
   R_SetFuzzColumnMode();
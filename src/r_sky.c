@@ -37,6 +37,7 @@
 #include "r_sky.h"
 #include "r_skydefs.h"
 #include "r_state.h"
+#include "v_palette.h"
 #include "w_wad.h"
 #include "z_zone.h"
 
@@ -417,7 +418,7 @@ static byte R_SkyBlendColor(int tex)
     b = colors[width / 3].b;
     Z_Free(colors);
 
-    return I_GetNearestColor(pal, r, g, b);
+    return V_NearestColor(V_InversePalette(pal), r, g, b);
 }
 
 typedef struct skycolor_s
@@ -91,6 +91,7 @@ extern side_t           *sides;
 
 extern int              *sslines_indexes;
 extern ssline_t         *sslines;
+extern linebox_t        *lineboxes;
 
 extern struct arena_s   *world_arena;
 
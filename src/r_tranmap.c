@@ -29,13 +29,16 @@
 #include "doomtype.h"
 #include "i_exit.h"
 #include "i_printf.h"
-#include "i_video.h"
+#include "i_thread.h"
+#include "i_timer.h"
 #include "m_argv.h"
 #include "m_io.h"
 #include "m_misc.h"
+#include "m_swap.h"
 #include "md5.h"
 #include "r_srgb.h"
 #include "r_tranmap.h"
+#include "v_palette.h"
 #include "w_wad.h"
 #include "z_zone.h"
 
@@ -49,9 +52,25 @@
 
 static const int playpal_base_layer = 256 * 3;    // RGB triplets
 
+// [Woof!] All tables of a palette are kept in a single cache file, which is
+// mapped into memory when it's read. Bump the magic whenever the blending
+// changes.
+
+static const char tranmap_magic[8] = "WOOFTM1";
+
+enum
+{
+    additive_slot = 100,
+    num_slots
+};
+
 static char playpal_string[33];
-static char *tranmap_dir, *playpal_dir;
-static byte *normal_tranmap[100];
+static char *cache_filename;
+static const byte *tables[num_slots];
+static boolean generated[num_slots]; // not from the cache file
+
+static byte *mapping;
+static int64_t mapping_length;
 
 const byte *tranmap;      // translucency filter maps 256x256   // phares
 const byte *main_tranmap; // killough 4/11/98
@@ -77,25 +96,171 @@ enum
 // * Subtractive -- alpha is a foreground multiplier, subtracted from unmodifed background
 //
 
-inline static const int BlendChannel(const byte fg, const byte bg,
+typedef struct
+{
+    const invpal_t *invpal;
+    double linear[256 * 3]; // the palette in linear color space
+    double fg_alpha, bg_alpha;
+    byte *buffer;
+} blend_t;
+
+typedef struct
+{
+    const blend_t *blend;
+    int first, last; // background colors
+} blendjob_t;
+
+inline static const int BlendChannel(const double fg_linear,
+                                     const double bg_linear,
                                      const double fg_alpha,
                                      const double bg_alpha)
 {
-    const double fg_linear = byte_to_linear(fg);
-    const double bg_linear = byte_to_linear(bg);
     const double r_linear = (fg_linear * fg_alpha) + (bg_linear * bg_alpha);
     return linear_to_byte(r_linear);
 }
 
-inline static const int ColorBlend(byte *playpal, const byte *fg,
-                                   const byte *bg, const double fg_alpha,
-                                   const double bg_alpha)
+inline static const int ColorBlend(const blend_t *blend, const double *fg,
+                                   const double *bg)
+{
+    int color[3] = {0};
+    color[r] = BlendChannel(fg[r], bg[r], blend->fg_alpha, blend->bg_alpha);
+    color[g] = BlendChannel(fg[g], bg[g], blend->fg_alpha, blend->bg_alpha);
+    color[b] = BlendChannel(fg[b], bg[b], blend->fg_alpha, blend->bg_alpha);
+    return V_NearestColor(blend->invpal, color[r], color[g], color[b]);
+}
+
+static void BlendRows(const blend_t *blend, int first, int last)
+{
+    byte *tp = blend->buffer + first * 256;
+
+    // Background
+    for (int i = first; i < last; i++)
+    {
+        const double *bg = blend->linear + 3 * i;
+
+        // Foreground
+        for (int j = 0; j < 256; j++)
+        {
+            const double *fg = blend->linear + 3 * j;
+
+            *tp++ = ColorBlend(blend, fg, bg);
+        }
+    }
+}
+
+static void BlendJob(void *data)
+{
+    const blendjob_t *job = data;
+
+    BlendRows(job->blend, job->first, job->last);
+}
+
+//
+// The heart of it all
+//
+// [Woof!] The rows of a table are blended on the worker threads. This may
+// run on any thread, the buffer and the inverse palette are set up before.
+//
+
+#define ROWS_PER_JOB 16
+
+static void GenerateTranmapRows(const blend_t *blend)
+{
+    blendjob_t jobs[256 / ROWS_PER_JOB];
+
+    if (I_NumWorkerThreads() == 0)
+    {
+        BlendRows(blend, 0, 256);
+        return;
+    }
+
+    jobgroup_t *group = I_CreateJobGroup();
+
+    for (int i = 0; i < arrlen(jobs); i++)
+    {
+        jobs[i].blend = blend;
+        jobs[i].first = i * ROWS_PER_JOB;
+        jobs[i].last = (i + 1) * ROWS_PER_JOB;
+        I_AddJob(group, BlendJob, &jobs[i]);
+    }
+
+    I_WaitJobGroup(group);
+}
+
+static void InitBlend(blend_t *blend, double fg_alpha, double bg_alpha)
+{
+    const byte *playpal = W_CacheLumpName("PLAYPAL", PU_STATIC);
+
+    blend->invpal = V_InversePalette(playpal);
+
+    for (int i = 0; i < arrlen(blend->linear); i++)
+    {
+        blend->linear[i] = byte_to_linear(playpal[i]);
+    }
+
+    blend->fg_alpha = fg_alpha;
+    blend->bg_alpha = bg_alpha;
+
+    // killough 4/11/98
+    blend->buffer = Z_Malloc(tranmap_lump_length, PU_STATIC, 0);
+}
+
+static byte *GenerateTranmapData(double fg_alpha, double bg_alpha)
 {
-    int blend[3] = {0};
-    blend[r] = BlendChannel(fg[r], bg[r], fg_alpha, bg_alpha);
-    blend[g] = BlendChannel(fg[g], bg[g], fg_alpha, bg_alpha);
-    blend[b] = BlendChannel(fg[b], bg[b], fg_alpha, bg_alpha);
-    return I_GetNearestColor(playpal, blend[r], blend[g], blend[b]);
+    blend_t *blend = malloc(sizeof(*blend));
+
+    InitBlend(blend, fg_alpha, bg_alpha);
+    GenerateTranmapRows(blend);
+
+    byte *buffer = blend->buffer;
+    free(blend);
+    return buffer;
+}
+
+//
+// [Woof!] The additive table isn't needed before the first level, so it's
+// blended in the background while the startup goes on. It is only published
+// in tables[] and main_addimap once R_WaitTranMaps() has seen it completed,
+// which P_SetupLevel() does before anything is drawn with it.
+//
+
+static jobgroup_t *background_group;
+static blend_t *background_blend;
+static int background_slot;
+
+static void BackgroundJob(void *data)
+{
+    GenerateTranmapRows(data);
+}
+
+static void StartBackgroundTranmap(int slot, double fg_alpha, double bg_alpha)
+{
+    background_blend = malloc(sizeof(*background_blend));
+    InitBlend(background_blend, fg_alpha, bg_alpha);
+
+    background_slot = slot;
+
+    background_group = I_CreateJobGroup();
+    I_AddJob(background_group, BackgroundJob, background_blend);
+}
+
+void R_WaitTranMaps(void)
+{
+    if (background_group)
+    {
+        I_WaitJobGroup(background_group);
+        background_group = NULL;
+
+        tables[background_slot] = background_blend->buffer;
+        generated[background_slot] = true;
+        if (background_slot == additive_slot)
+        {
+            main_addimap = tables[additive_slot];
+        }
+
+        free(background_blend);
+        background_blend = NULL;
+    }
 }
 
 //
@@ -114,123 +279,176 @@ static void CalculatePlaypalChecksum(void)
     M_DigestToString(playpal_digest, playpal_string, sizeof(playpal_digest));
 }
 
-static void CreateTranMapBaseDir(void)
+static void CreateCacheFilename(void)
 {
-    const char *data_root = D_DoomPrefDir();
-    const int length = strlen(data_root) + sizeof("/tranmaps");
-
-    tranmap_dir = malloc(length);
-    M_snprintf(tranmap_dir, length, "%s/tranmaps", data_root);
+    char *dir = M_StringJoin(D_DoomPrefDir(), DIR_SEPARATOR_S, "tranmaps");
+    M_MakeDirectory(dir);
 
-    M_MakeDirectory(tranmap_dir);
+    cache_filename = M_StringJoin(dir, DIR_SEPARATOR_S, playpal_string, ".dat");
+    free(dir);
 }
 
-static void CreateTranMapPaletteDir(void)
+//
+// The cache file holds the magic, the number of tables, their slots and then
+// the tables themselves.
+//
+
+static void ReadTranMapCache(void)
 {
-    if (!tranmap_dir)
+    const int fd = M_open(cache_filename);
+
+    if (fd < 0)
     {
-        CreateTranMapBaseDir();
+        return;
     }
 
-    if (!playpal_string[0])
+    const int64_t length = M_filesize(fd);
+    const int64_t header_length = sizeof(tranmap_magic) + sizeof(int);
+
+    if (length >= header_length)
     {
-        CalculatePlaypalChecksum();
+        mapping = M_mmap(fd, length);
+        mapping_length = length;
     }
 
-    int length = strlen(tranmap_dir) + sizeof(playpal_string) + 1;
-    playpal_dir = malloc(length);
-    M_snprintf(playpal_dir, length, "%s/%s", tranmap_dir, playpal_string);
-    free(tranmap_dir);
-    tranmap_dir = NULL;
+    M_close(fd);
 
-    M_MakeDirectory(playpal_dir);
-}
+    if (!mapping)
+    {
+        return;
+    }
 
-//
-// The heart of it all
-//
+    int count;
+    memcpy(&count, mapping + sizeof(tranmap_magic), sizeof(count));
+    count = LONG(count);
 
-static byte *GenerateTranmapData(double fg_alpha, double bg_alpha)
-{
-    byte *playpal = W_CacheLumpName("PLAYPAL", PU_STATIC);
+    if (memcmp(mapping, tranmap_magic, sizeof(tranmap_magic))
+        || count < 0 || count > num_slots
+        || length != header_length
+                     + (int64_t)count * (sizeof(int) + tranmap_lump_length))
+    {
+        I_Printf(VB_DEBUG, "ReadTranMapCache: Ignoring %s", cache_filename);
+        M_munmap(mapping, mapping_length);
+        mapping = NULL;
+        return;
+    }
 
-    // killough 4/11/98
-    byte *buffer = Z_Malloc(tranmap_lump_length, PU_STATIC, 0);
-    byte *tp = buffer;
+    const byte *slots = mapping + header_length;
+    const byte *data = slots + count * sizeof(int);
 
-    // Background
-    for (int i = 0; i < 256; i++)
+    for (int i = 0; i < count; i++)
     {
-        const byte *bg = playpal + 3 * i;
+        int slot;
+        memcpy(&slot, slots + i * sizeof(int), sizeof(slot));
+        slot = LONG(slot);
 
-        // killough 10/98: display flashing disk
-        if (!(~i & 15))
+        if (slot >= 0 && slot < num_slots)
         {
-            if (i & 32)
-            {
-                I_EndRead();
-            }
-            else
-            {
-                I_BeginRead(DISK_ICON_THRESHOLD);
-            }
+            tables[slot] = data + i * tranmap_lump_length;
         }
+    }
+}
 
-        // Foreground
-        for (int j = 0; j < 256; j++)
-        {
-            const byte *fg = playpal + 3 * j;
+static void WriteTranMapCache(void)
+{
+    R_WaitTranMaps();
+
+    boolean dirty = false;
+    int count = 0;
 
-            *tp++ = ColorBlend(playpal, fg, bg, fg_alpha, bg_alpha);
+    for (int i = 0; i < num_slots; i++)
+    {
+        if (tables[i])
+        {
+            dirty |= generated[i];
+            count++;
         }
     }
 
-    return buffer;
-}
-
-byte *R_NormalTranMap(int alpha, boolean force)
-{
-    if (alpha > 99)
+    if (!dirty || !cache_filename)
     {
-        return NULL;
+        return;
     }
 
-    if (force || !normal_tranmap[alpha])
+    const int header_length = sizeof(tranmap_magic) + sizeof(int);
+    const int length = header_length + count * (sizeof(int) + tranmap_lump_length);
+    byte *buffer = malloc(length);
+    byte *slots = buffer + header_length;
+    byte *data = slots + count * sizeof(int);
+    int value;
+
+    memcpy(buffer, tranmap_magic, sizeof(tranmap_magic));
+    value = LONG(count);
+    memcpy(buffer + sizeof(tranmap_magic), &value, sizeof(value));
+
+    for (int i = 0; i < num_slots; i++)
     {
-        if (!playpal_dir)
+        if (tables[i])
         {
-            CreateTranMapPaletteDir();
+            value = LONG(i);
+            memcpy(slots, &value, sizeof(value));
+            memcpy(data, tables[i], tranmap_lump_length);
+            slots += sizeof(int);
+            data += tranmap_lump_length;
         }
+    }
 
-        const int length = strlen(playpal_dir) + sizeof("/tranmap_XY.dat");
-        char *filename = malloc(length);
-        M_snprintf(filename, length, "%s/tranmap_%02d.dat", playpal_dir, alpha);
-        free(playpal_dir);
-        playpal_dir = NULL;
+    // The file can't be replaced while it's mapped on some systems.
+    if (mapping)
+    {
+        memset(tables, 0, sizeof(tables));
+        main_tranmap = main_addimap = tranmap = NULL;
+        M_munmap(mapping, mapping_length);
+        mapping = NULL;
+    }
+
+    // Other processes may still have the old file mapped, so it is replaced
+    // as a whole instead of being rewritten in place. The temporary name is
+    // unique, e.g. for several -demolist jobs exiting at once.
+    char suffix[32];
+    M_snprintf(suffix, sizeof(suffix), ".%llx.tmp",
+               (unsigned long long)I_GetTimeNS());
+    char *tmpfile = M_StringJoin(cache_filename, suffix);
 
-        byte *buffer = NULL;
-        if (!force && M_FileExistsNotDir(filename))
+    if (M_WriteFile(tmpfile, buffer, length))
+    {
+        if (M_rename(tmpfile, cache_filename) == 0)
         {
-            const int file_length = M_ReadFile(filename, &buffer);
-            if (buffer && file_length != tranmap_lump_length)
-            {
-                Z_Free(buffer);
-                buffer = NULL;
-            }
+            I_Printf(VB_DEBUG, "WriteTranMapCache: Wrote %d tables to %s",
+                     count, cache_filename);
         }
-
-        if (force || !buffer)
+        else
         {
-            buffer = GenerateTranmapData(alpha / 100.0, 1.0 - (alpha / 100.0));
-            M_WriteFile(filename, buffer, tranmap_lump_length);
+            M_remove(tmpfile);
         }
-        free(filename);
+    }
+
+    free(tmpfile);
+    free(buffer);
+}
 
-        normal_tranmap[alpha] = buffer;
+void R_DisableTranMapCache(void)
+{
+    free(cache_filename);
+    cache_filename = NULL;
+}
+
+const byte *R_NormalTranMap(int alpha, boolean force)
+{
+    if (alpha > 99)
+    {
+        return NULL;
+    }
+
+    if (force || !tables[alpha])
+    {
+        tables[alpha] =
+            GenerateTranmapData(alpha / 100.0, 1.0 - (alpha / 100.0));
+        generated[alpha] = true;
     }
 
     // Use cached translucency filter if it's available
-    return normal_tranmap[alpha];
+    return tables[alpha];
 }
 
 void R_InitTranMap(void)
@@ -243,17 +461,41 @@ void R_InitTranMap(void)
     const int force_rebuild = M_CheckParm("-tranmap");
     const int lump = W_CheckNumForName("TRANMAP");
 
+    CalculatePlaypalChecksum();
+    CreateCacheFilename();
+
+    if (!force_rebuild)
+    {
+        ReadTranMapCache();
+    }
+
+    I_AtExit(WriteTranMapCache, false);
+
     if (lump != -1 && !force_rebuild)
     {
         main_tranmap = W_CacheLumpNum(lump, PU_STATIC);
     }
     else
     {
-        main_tranmap = R_NormalTranMap(default_tranmap_alpha, true);
+        main_tranmap = R_NormalTranMap(default_tranmap_alpha, force_rebuild);
     }
 
     // Some things look better with added luminosity :)
-    main_addimap = strictmode ? main_tranmap : GenerateTranmapData(1.0, 0.5);
+    if (strictmode)
+    {
+        main_addimap = main_tranmap;
+    }
+    else
+    {
+        if (tables[additive_slot])
+        {
+            main_addimap = tables[additive_slot];
+        }
+        else
+        {
+            StartBackgroundTranmap(additive_slot, 1.0, 0.5);
+        }
+    }
 
     I_Printf(VB_INFO, "Playpal checksum: %s", playpal_string);
 
@@ -34,7 +34,13 @@ static const int default_tranmap_alpha = 66;
 
 // killough 3/6/98: translucency initialization
 void R_InitTranMap(void);
-byte *R_NormalTranMap(int alpha, boolean force);
+const byte *R_NormalTranMap(int alpha, boolean force);
 #define GetNormalTranMap(alpha) R_NormalTranMap(alpha, false)
 
+// Waits for the tables that are generated in the background.
+void R_WaitTranMaps(void);
+
+// Leaves the cache file alone on exit.
+void R_DisableTranMapCache(void);
+
 #endif
@@ -33,6 +33,7 @@
 #include "r_state.h"
 #include "r_things.h"
 #include "tables.h"
+#include "v_palette.h"
 #include "v_video.h"
 #include "w_wad.h"
 #include "z_zone.h"
@@ -75,34 +76,10 @@ enum VoxelFace
 };
 
 
-static int VX_PaletteIndex (byte * pal, int r, int g, int b)
-{
-	int best = 0;
-	int best_dist = (1 << 30);
-
-	int i;
-	for (i = 0 ; i < 256 ; i++)
-	{
-		int dr = r - (int)*pal++;
-		int dg = g - (int)*pal++;
-		int db = b - (int)*pal++;
-
-		int dist = dr * dr + dg * dg + db * db;
-
-		if (dist < best_dist)
-		{
-			best = i;
-			best_dist = dist;
-		}
-	}
-
-	return best;
-}
-
-
 static void VX_CreateRemapTable (byte * p, byte * table)
 {
-	byte * pal = W_CacheLumpName ("PLAYPAL", PU_CACHE);
+	// [Woof!] same result as the former linear search
+	const invpal_t * invpal = V_InversePalette (W_CacheLumpName ("PLAYPAL", PU_CACHE));
 
 	int c;
 	for (c = 0 ; c < 256 ; c++)
@@ -111,7 +88,7 @@ static void VX_CreateRemapTable (byte * p, byte * table)
 		int g = (int)*p++ << 2;
 		int b = (int)*p++ << 2;
 
-		table[c] = VX_PaletteIndex (pal, r, g, b);
+		table[c] = V_NearestColor (invpal, r, g, b);
 	}
 }
 
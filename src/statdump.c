@@ -297,9 +297,18 @@ static void PrintStats(FILE *stream, const wbstartstruct_t *stats)
     fprintf(stream, "\n");
 }
 
+// [Woof!] Replaces the file given with -statdump.
+static const char *dump_filename;
+
+void StatDumpTo(const char *filename)
+{
+    dump_filename = filename;
+}
+
 void StatCopy(const wbstartstruct_t *stats)
 {
-    if (M_CheckParm("-statdump") && num_captured_stats < MAX_CAPTURES)
+    if ((dump_filename || M_CheckParm("-statdump"))
+        && num_captured_stats < MAX_CAPTURES)
     {
         memcpy(&captured_stats[num_captured_stats], stats,
                sizeof(wbstartstruct_t));
@@ -310,6 +319,7 @@ void StatCopy(const wbstartstruct_t *stats)
 void StatDump(void)
 {
     FILE *dumpfile;
+    const char *filename = dump_filename;
     int i;
 
     //!
@@ -323,7 +333,12 @@ void StatDump(void)
 
     i = M_CheckParm("-statdump");
 
-    if (i > 0 && i < myargc - 1)
+    if (!filename && i > 0 && i < myargc - 1)
+    {
+        filename = myargv[i + 1];
+    }
+
+    if (filename)
     {
         I_Printf(VB_ALWAYS, "Statistics captured for %i level(s)",
                  num_captured_stats);
@@ -335,9 +350,9 @@ void StatDump(void)
 
         // Allow "-" as output file, for stdout.
 
-        if (strcmp(myargv[i + 1], "-") != 0)
+        if (strcmp(filename, "-") != 0)
         {
-            dumpfile = M_fopen(myargv[i + 1], "w");
+            dumpfile = M_fopen(filename, "w");
         }
         else
         {
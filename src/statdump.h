@@ -22,4 +22,7 @@ struct wbstartstruct_s;
 void StatCopy(const struct wbstartstruct_s *stats);
 void StatDump(void);
 
+// [Woof!] Capture statistics and write them to the given file at exit.
+void StatDumpTo(const char *filename);
+
 #endif /* #ifndef DOOM_STATDUMP_H */
@@ -30,7 +30,7 @@
 
 #include "v_flextran.h"
 
-#include "i_video.h"
+#include "v_palette.h"
 #include "w_wad.h"
 #include "z_zone.h"
 
@@ -54,6 +54,7 @@ void V_InitFlexTranTable(void)
     const byte *palRover;
 
     byte *palette = W_CacheLumpName("PLAYPAL", PU_STATIC);
+    const invpal_t *invpal = V_InversePalette(palette);
 
     tempRGBpal = Z_Malloc(256 * sizeof(*tempRGBpal), PU_STATIC, 0);
 
@@ -71,8 +72,8 @@ void V_InitFlexTranTable(void)
         {
             for (b = 0; b < 32; ++b)
             {
-                RGB32k[r][g][b] = I_GetNearestColor(palette, MAKECOLOR(r),
-                                                    MAKECOLOR(g), MAKECOLOR(b));
+                RGB32k[r][g][b] = V_NearestColor(invpal, MAKECOLOR(r),
+                                                 MAKECOLOR(g), MAKECOLOR(b));
             }
         }
     }
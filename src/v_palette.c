@@ -0,0 +1,171 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Inverse palettes for fast nearest color searches.
+//
+//      The RGB cube is divided into cells, and each cell keeps the palette
+//      colors that can be the nearest color of any point inside it. A color
+//      whose distance to the cell is larger than the largest distance of some
+//      other color to any point of the cell can never win, not even a tie.
+//      The remaining candidates are kept in palette order and searched like
+//      the whole palette, so the results are exactly the same.
+//
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "i_printf.h"
+#include "i_timer.h"
+#include "i_video.h"
+#include "m_array.h"
+#include "v_palette.h"
+
+#define CELL_BITS  4
+#define CELL_SIZE  (1 << CELL_BITS)
+#define GRID_SIZE  (256 / CELL_SIZE)
+#define NUM_CELLS  (GRID_SIZE * GRID_SIZE * GRID_SIZE)
+
+typedef struct
+{
+    byte r, g, b, index;
+} candidate_t;
+
+struct invpal_s
+{
+    byte palette[256 * 3];
+    int first[NUM_CELLS + 1]; // index of the first candidate of each cell
+    candidate_t *candidates;
+};
+
+static invpal_t **inverse_palettes;
+
+// Distances from a channel value to the nearest and the farthest point of
+// a cell along that channel.
+
+static int MinDist(int v, int lo)
+{
+    const int d = v < lo ? lo - v : v > lo + CELL_SIZE - 1 ? v - (lo + CELL_SIZE - 1) : 0;
+    return d * d;
+}
+
+static int MaxDist(int v, int lo)
+{
+    const int d = MAX(abs(v - lo), abs(v - (lo + CELL_SIZE - 1)));
+    return d * d;
+}
+
+static void BuildCell(invpal_t *invpal, int cr, int cg, int cb)
+{
+    const byte *p;
+    int bound = INT_MAX;
+
+    p = invpal->palette;
+    for (int i = 0; i < 256; ++i, p += 3)
+    {
+        const int maxd = MaxDist(p[0], cr) + MaxDist(p[1], cg)
+                         + MaxDist(p[2], cb);
+        bound = MIN(bound, maxd);
+    }
+
+    p = invpal->palette;
+    for (int i = 0; i < 256; ++i, p += 3)
+    {
+        const int mind = MinDist(p[0], cr) + MinDist(p[1], cg)
+                         + MinDist(p[2], cb);
+
+        if (mind <= bound)
+        {
+            candidate_t c = {p[0], p[1], p[2], i};
+            array_push(invpal->candidates, c);
+        }
+    }
+}
+
+static invpal_t *BuildInversePalette(const byte *palette)
+{
+    const uint64_t start = I_GetTimeNS();
+    invpal_t *invpal = calloc(1, sizeof(*invpal));
+    int cell = 0;
+
+    memcpy(invpal->palette, palette, sizeof(invpal->palette));
+
+    for (int r = 0; r < GRID_SIZE; ++r)
+    {
+        for (int g = 0; g < GRID_SIZE; ++g)
+        {
+            for (int b = 0; b < GRID_SIZE; ++b)
+            {
+                invpal->first[cell++] = array_size(invpal->candidates);
+                BuildCell(invpal, r * CELL_SIZE, g * CELL_SIZE, b * CELL_SIZE);
+            }
+        }
+    }
+    invpal->first[cell] = array_size(invpal->candidates);
+
+    I_Printf(VB_DEBUG,
+             "V_InversePalette: %.1f candidates per cell, built in %.2f ms",
+             (double)array_size(invpal->candidates) / NUM_CELLS,
+             (I_GetTimeNS() - start) / 1000000.0);
+
+    return invpal;
+}
+
+const invpal_t *V_InversePalette(const byte *palette)
+{
+    invpal_t **invpal;
+
+    array_foreach(invpal, inverse_palettes)
+    {
+        if (!memcmp((*invpal)->palette, palette, sizeof((*invpal)->palette)))
+        {
+            return *invpal;
+        }
+    }
+
+    array_push(inverse_palettes, BuildInversePalette(palette));
+    return inverse_palettes[array_size(inverse_palettes) - 1];
+}
+
+byte V_NearestColor(const invpal_t *invpal, int r, int g, int b)
+{
+    // Out of range colors are searched in the whole palette.
+    if ((unsigned int)(r | g | b) > 255)
+    {
+        return I_GetNearestColor((byte *)invpal->palette, r, g, b);
+    }
+
+    const int cell = (((r >> CELL_BITS) * GRID_SIZE + (g >> CELL_BITS))
+                      * GRID_SIZE) + (b >> CELL_BITS);
+    const candidate_t *c = invpal->candidates + invpal->first[cell];
+    const candidate_t *end = invpal->candidates + invpal->first[cell + 1];
+    int best = c->index;
+    int best_diff = INT_MAX;
+
+    for (; c < end; ++c)
+    {
+        const int dr = r - c->r;
+        const int dg = g - c->g;
+        const int db = b - c->b;
+        const int diff = dr * dr + dg * dg + db * db;
+
+        if (diff < best_diff)
+        {
+            best = c->index;
+            best_diff = diff;
+        }
+    }
+
+    return best;
+}
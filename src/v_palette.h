@@ -0,0 +1,33 @@
+//
+// Copyright(C) 2026 Fabian Greffrath and contributors
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Inverse palettes for fast nearest color searches.
+//
+
+#ifndef __V_PALETTE__
+#define __V_PALETTE__
+
+#include "doomtype.h"
+
+typedef struct invpal_s invpal_t;
+
+// Returns the inverse of a 256 color palette. It is built on the first call
+// for each palette and cached, so this must be called from the main thread.
+const invpal_t *V_InversePalette(const byte *palette);
+
+// Same result as I_GetNearestColor() for the palette, may be called from any
+// thread.
+byte V_NearestColor(const invpal_t *invpal, int r, int g, int b);
+
+#endif
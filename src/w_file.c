@@ -67,8 +67,8 @@ static boolean W_FILE_AddDir(w_handle_t handle, const char *path,
             W_AddMarker(start_marker);
         }
 
-        FILE *descriptor = M_fopen(filename, "rb");
-        if (descriptor == NULL)
+        int descriptor = M_open(filename);
+        if (descriptor < 0)
         {
             I_Error("Error opening %s", filename);
         }
@@ -98,7 +98,9 @@ static boolean W_FILE_AddDir(w_handle_t handle, const char *path,
     return true;
 }
 
-static FILE **descriptors = NULL;
+static int *descriptors = NULL;
+
+#define WILLNEED_MAX_SIZE (64 * 1024 * 1024)
 
 static w_type_t W_FILE_Open(const char *path, w_handle_t *handle)
 {
@@ -108,8 +110,8 @@ static w_type_t W_FILE_Open(const char *path, w_handle_t *handle)
         return W_DIR;
     }
 
-    FILE *descriptor = M_fopen(path, "rb");
-    if (descriptor == NULL)
+    int descriptor = M_open(path);
+    if (descriptor < 0)
     {
         return W_NONE;
     }
@@ -139,18 +141,19 @@ static w_type_t W_FILE_Open(const char *path, w_handle_t *handle)
 
     wadinfo_t header;
 
-    if (fread(&header, 1, sizeof(header), descriptor) < sizeof(header))
+    if (M_pread(descriptor, &header, sizeof(header), 0)
+        != (int64_t)sizeof(header))
     {
         I_Printf(VB_WARNING, "Error reading header from %s (%s)", path,
                  strerror(errno));
-        fclose(descriptor);
+        M_close(descriptor);
         return W_NONE;
     }
 
     if (strncmp(header.identification, "IWAD", 4)
         && strncmp(header.identification, "PWAD", 4))
     {
-        fclose(descriptor);
+        M_close(descriptor);
         return W_NONE;
     }
 
@@ -158,7 +161,7 @@ static w_type_t W_FILE_Open(const char *path, w_handle_t *handle)
     if (header.numlumps == 0)
     {
         I_Printf(VB_WARNING, "Wad file %s is empty", path);
-        fclose(descriptor);
+        M_close(descriptor);
         return W_NONE;
     }
 
@@ -170,26 +173,26 @@ static w_type_t W_FILE_Open(const char *path, w_handle_t *handle)
     }
 
     header.infotableofs = LONG(header.infotableofs);
-    if (fseek(descriptor, header.infotableofs, SEEK_SET) == -1)
-    {
-        I_Printf(VB_WARNING, "Error seeking offset from %s (%s)", path,
-                 strerror(errno));
-        fclose(descriptor);
-        free(fileinfo);
-        return W_NONE;
-    }
-
-    if (fread(fileinfo, sizeof(filelump_t), header.numlumps, descriptor) < header.numlumps)
+    if (M_pread(descriptor, fileinfo, length, header.infotableofs) < length)
     {
         I_Printf(VB_WARNING, "Error reading lump directory from %s (%s)", path,
                  strerror(errno));
-        fclose(descriptor);
+        M_close(descriptor);
         free(fileinfo);
         return W_NONE;
     }
 
     array_push(descriptors, descriptor);
 
+    // Lumps of small wads are mostly read at startup, so let the OS start
+    // reading them in the background. Large texture packs are only read on
+    // demand.
+    int64_t filesize = M_filesize(descriptor);
+    if (filesize > 0 && filesize <= WILLNEED_MAX_SIZE)
+    {
+        M_fadvise(descriptor, 0, filesize, FADVISE_WILLNEED);
+    }
+
     numlumps += header.numlumps;
 
     const char *wadname = M_StringDuplicate(M_BaseName(path));
@@ -214,13 +217,15 @@ static w_type_t W_FILE_Open(const char *path, w_handle_t *handle)
     return W_FILE;
 }
 
+// Uses positional reads, so lumps may be read from several threads.
+
 static void W_FILE_Read(w_handle_t handle, void *dest, int size)
 {
-    fseek(handle.p1.descriptor, handle.p2.position, SEEK_SET);
-    int bytesread = fread(dest, 1, size, handle.p1.descriptor);
+    int64_t bytesread =
+        M_pread(handle.p1.descriptor, dest, size, handle.p2.position);
     if (bytesread < size)
     {
-        I_Error("only read %d of %d", bytesread, size);
+        I_Error("only read %d of %d", (int)bytesread, size);
     }
 }
 
@@ -228,7 +233,7 @@ static void W_FILE_Close(void)
 {
     for (int i = 0; i < array_size(descriptors); ++i)
     {
-        fclose(descriptors[i]);
+        M_close(descriptors[i]);
     }
 }
 
@@ -237,5 +242,6 @@ w_module_t w_file_module =
     W_FILE_AddDir,
     W_FILE_Open,
     W_FILE_Read,
-    W_FILE_Close
+    W_FILE_Close,
+    NULL // descriptors are read with M_pread()
 };
@@ -30,6 +30,7 @@ typedef struct w_module_s
     w_type_t (*Open)(const char *path, w_handle_t *handle);
     void (*Read)(w_handle_t handle, void *dest, int size);
     void (*Close)(void);
+    void (*Reopen)(void); // [Woof!] may be NULL
 } w_module_t;
 
 extern w_module_t w_zip_module;
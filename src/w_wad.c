@@ -24,9 +24,13 @@
 #include "doomdef.h"
 #include "doomstat.h"
 #include "doomtype.h"
+#include "i_exit.h"
 #include "i_printf.h"
 #include "i_system.h"
+#include "i_timer.h"
+#include "m_argv.h"
 #include "m_array.h"
+#include "m_hashmap.h"
 #include "m_misc.h"
 #include "w_wad.h"
 #include "w_internal.h"
@@ -310,7 +314,7 @@ unsigned W_LumpNameHash(const char *s)
 }
 
 //
-// W_CheckNumForName
+// CheckNumForNameChained
 // Returns -1 if name not found.
 //
 // Rewritten by Lee Killough to use hash table for performance. Significantly
@@ -328,7 +332,7 @@ unsigned W_LumpNameHash(const char *s)
 // between different resources such as flats, sprites, colormaps
 //
 
-int (W_CheckNumForName)(register const char *name, register int name_space) // [FG] namespace is reserved in C++
+static int CheckNumForNameChained(const char *name, int name_space)
 {
   // Hash function maps the name to one of possibly numlump chains.
   // It has been tuned so that the average chain length never exceeds 2.
@@ -375,6 +379,207 @@ static void W_InitLumpHash(void)
 
 // End of lump hashing -- killough 1/31/98
 
+// [Woof!] The killough chains above are still used by W_ProcessInWads(),
+// which needs to visit every lump with a given name. Plain lookups go through
+// a separate open addressing table per namespace, built once after the lump
+// directory is final. Names are packed into uppercase 64-bit keys, so a probe
+// is a single integer compare instead of strncasecmp(). Keys and lump numbers
+// are stored in separate arrays and probed linearly, so a probe sequence
+// walks consecutive 64-bit words.
+
+typedef struct
+{
+    uint64_t *keys;
+    int *lumps;
+    unsigned int mask;
+} lumptable_t;
+
+static lumptable_t lumptables[ns_hires + 1];
+
+inline static uint64_t PackLumpName(const char *name)
+{
+    uint64_t key = 0;
+
+    for (int i = 0; i < 8 && name[i]; ++i)
+    {
+        byte c = name[i];
+        if (c >= 'a' && c <= 'z')
+        {
+            c -= 'a' - 'A';
+        }
+        key |= (uint64_t)c << (i * 8);
+    }
+
+    return key;
+}
+
+inline static unsigned int LumpKeyHash(uint64_t key)
+{
+    key *= 0x9E3779B97F4A7C15ull;
+    return (unsigned int)(key >> 32);
+}
+
+static void InitLumpTables(void)
+{
+    int count[arrlen(lumptables)] = {0};
+
+    for (int i = 0; i < numlumps; ++i)
+    {
+        count[lumpinfo[i].namespace]++;
+    }
+
+    for (int ns = 0; ns < arrlen(lumptables); ++ns)
+    {
+        lumptable_t *table = &lumptables[ns];
+
+        free(table->keys);
+        free(table->lumps);
+
+        // Keep the load factor at or below 50%.
+        unsigned int size = 8;
+        while (size < 2 * count[ns])
+        {
+            size <<= 1;
+        }
+
+        table->keys = calloc(size, sizeof(*table->keys));
+        table->lumps = malloc(size * sizeof(*table->lumps));
+        table->mask = size - 1;
+
+        for (int i = 0; i < size; ++i)
+        {
+            table->lumps[i] = -1;
+        }
+    }
+
+    // Insert in first-to-last lump order, so that the last lump of a given
+    // name wins, observing pwad ordering rules.
+
+    for (int i = 0; i < numlumps; ++i)
+    {
+        lumptable_t *table = &lumptables[lumpinfo[i].namespace];
+        uint64_t key = PackLumpName(lumpinfo[i].name);
+        unsigned int slot = LumpKeyHash(key) & table->mask;
+
+        while (table->lumps[slot] >= 0 && table->keys[slot] != key)
+        {
+            slot = (slot + 1) & table->mask;
+        }
+
+        table->keys[slot] = key;
+        table->lumps[slot] = i;
+    }
+}
+
+static int CheckNumForNameTable(const char *name, int name_space)
+{
+    const lumptable_t *table = &lumptables[name_space];
+    const uint64_t key = PackLumpName(name);
+    unsigned int slot = LumpKeyHash(key) & table->mask;
+
+    while (table->lumps[slot] >= 0)
+    {
+        if (table->keys[slot] == key)
+        {
+            return table->lumps[slot];
+        }
+        slot = (slot + 1) & table->mask;
+    }
+
+    return -1;
+}
+
+// Lookups recorded for -lumpbench.
+
+typedef struct
+{
+    char name[8];
+    int name_space;
+} lookup_t;
+
+static boolean record_lookups;
+static lookup_t *lookups;
+
+//
+// W_CheckNumForName
+// Returns -1 if name not found.
+//
+// [Woof!] Uses the packed per-namespace tables, see above.
+//
+
+int (W_CheckNumForName)(const char *name, int name_space) // [FG] namespace is reserved in C++
+{
+  if (record_lookups)
+  {
+    lookup_t lookup = {0};
+    M_CopyLumpName(lookup.name, name);
+    lookup.name_space = name_space;
+    array_push(lookups, lookup);
+  }
+
+  return CheckNumForNameTable(name, name_space);
+}
+
+// Replay the recorded lookups through both the chained hash and the packed
+// tables, check that they agree and report the time spent in each.
+
+static void LumpBenchmark(void)
+{
+    const int count = array_size(lookups);
+    const int passes = 100;
+
+    if (!count)
+    {
+        return;
+    }
+
+    int mismatches = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (CheckNumForNameChained(lookups[i].name, lookups[i].name_space)
+            != CheckNumForNameTable(lookups[i].name, lookups[i].name_space))
+        {
+            ++mismatches;
+        }
+    }
+
+    volatile int sink = 0;
+
+    uint64_t start = I_GetTimeUS();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            sink += CheckNumForNameChained(lookups[i].name,
+                                           lookups[i].name_space);
+        }
+    }
+    uint64_t chained = I_GetTimeUS() - start;
+
+    start = I_GetTimeUS();
+    for (int pass = 0; pass < passes; ++pass)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            sink += CheckNumForNameTable(lookups[i].name,
+                                         lookups[i].name_space);
+        }
+    }
+    uint64_t table = I_GetTimeUS() - start;
+
+    const double total = (double)count * passes;
+
+    I_Printf(VB_ALWAYS,
+             "W_CheckNumForName: %d lookups in %d lumps, %d passes\n"
+             "  chained: %8.2f ns/lookup\n"
+             "  packed:  %8.2f ns/lookup\n"
+             "  mismatches: %d",
+             count, numlumps, passes, chained * 1000.0 / total,
+             table * 1000.0 / total, mismatches);
+
+    (void)sink;
+}
+
 //
 // W_GetNumForName
 // Calls W_CheckNumForName, but bombs out if not found.
@@ -401,6 +606,116 @@ const char *W_CheckWidescreenPatch(const char *lump_main)
   return lump_main;
 }
 
+// [Woof!] Optional sharing of cached lumps with identical content, e.g. the
+// same patches, sounds or DEHACKED lumps in several autoloaded wads. The first
+// time a lump is read, its data is hashed. If a lump of the same namespace,
+// size and content is already cached, the new copy is dropped and the lump is
+// redirected to the cache entry of the other one for good, so both behave as
+// if they were the same lump. Callers retag cached lumps as they please, so
+// every lump sharing a block remembers the tag it was last requested with,
+// and the block keeps the strongest of them. Once all of them have been
+// released to PU_CACHE, the block becomes purgable again.
+
+static boolean dedup_lumps;
+static hashmap_t *lump_contents; // content hash -> lump
+static size_t dedup_bytes;
+static int dedup_count;
+
+static uint64_t HashLumpData(const byte *data, int size, namespace_t ns)
+{
+    uint64_t hash = 0xcbf29ce484222325 ^ ns;
+    int i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * 0x100000001b3;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; ++i)
+    {
+        hash = (hash ^ data[i]) * 0x100000001b3;
+    }
+
+    return hash;
+}
+
+static int DedupLump(int lump)
+{
+    const lumpinfo_t *info = &lumpinfo[lump];
+    const byte *data = lumpcache[lump];
+
+    // PNG lumps are replaced by converted patches or flats in the cache, see
+    // V_CachePatchNum(), so their cache entries can't be compared.
+    if (info->size < 8 || !memcmp(data, "\211PNG\r\n\032\n", 8))
+    {
+        return lump;
+    }
+
+    uint64_t key = HashLumpData(data, info->size, info->namespace);
+    int *found = hashmap_get(lump_contents, key);
+
+    // A lump that others already share with can't follow another one.
+    if (found && *found != lump && lumpinfo[lump].cachenext < 0)
+    {
+        const int other = *found;
+        const lumpinfo_t *other_info = &lumpinfo[other];
+
+        if (lumpcache[other] && other_info->size == info->size
+            && other_info->namespace == info->namespace
+            && !memcmp(lumpcache[other], data, info->size))
+        {
+            Z_Free(lumpcache[lump]);
+            lumpinfo[lump].cachelump = other;
+            lumpinfo[lump].cachenext = lumpinfo[other].cachenext;
+            lumpinfo[other].cachenext = lump;
+            dedup_bytes += info->size;
+            ++dedup_count;
+            return other;
+        }
+    }
+
+    hashmap_put(lump_contents, key, &lump);
+    return lump;
+}
+
+// Records the tag `lump` was requested with and returns the strongest tag of
+// all lumps that share the block of `shared`. A freshly read block has no
+// other users, their tags belong to a block that has been freed since.
+
+static pu_tag SharedLumpTag(int lump, int shared, pu_tag tag, boolean fresh)
+{
+    if (lumpinfo[shared].cachenext < 0)
+    {
+        return tag;
+    }
+
+    if (fresh)
+    {
+        for (int i = shared; i >= 0; i = lumpinfo[i].cachenext)
+        {
+            lumpinfo[i].cachetag = PU_CACHE;
+        }
+    }
+
+    lumpinfo[lump].cachetag = tag;
+
+    for (int i = shared; i >= 0; i = lumpinfo[i].cachenext)
+    {
+        tag = MIN(tag, lumpinfo[i].cachetag);
+    }
+
+    return tag;
+}
+
+static void DedupReport(void)
+{
+    I_Printf(VB_INFO,
+             "W_CacheLumpNum: %d duplicate lumps shared, %zu bytes saved",
+             dedup_count, dedup_bytes);
+}
+
 //
 // W_InitMultipleFiles
 // Pass a null terminated list of files to use.
@@ -469,8 +784,45 @@ void W_InitMultipleFiles(void)
   if (!lumpcache)
     I_Error ("Couldn't allocate lumpcache");
 
+  for (int i = 0; i < numlumps; ++i)
+  {
+    lumpinfo[i].cachelump = i;
+    lumpinfo[i].cachenext = -1;
+    lumpinfo[i].cachetag = PU_CACHE;
+  }
+
+  //!
+  // @category obscure
+  //
+  // Share the cached data of lumps with identical content, e.g. the same
+  // patches or sounds in several autoloaded wads. Print the number of bytes
+  // saved at exit.
+  //
+
+  if (M_ParmExists("-deduplumps"))
+  {
+    dedup_lumps = true;
+    lump_contents = hashmap_init(1024, sizeof(int));
+    I_AtExit(DedupReport, false);
+  }
+
   // killough 1/31/98: initialize lump hash table
   W_InitLumpHash();
+
+  InitLumpTables();
+
+  //!
+  // @category obscure
+  //
+  // Record every lump name lookup and, at exit, replay them through the old
+  // chained hash and the packed lookup tables and print timings.
+  //
+
+  if (M_ParmExists("-lumpbench"))
+  {
+    record_lookups = true;
+    I_AtExit(LumpBenchmark, false);
+  }
 }
 
 //
@@ -536,17 +888,35 @@ void W_ReadLump(int lump, void *dest)
 
 void *W_CacheLumpNum(int lump, pu_tag tag)
 {
+  int shared;
+  boolean fresh = false;
+
 #ifdef RANGECHECK
   if ((unsigned)lump >= numlumps)
     I_Error ("%i >= numlumps",lump);
 #endif
 
-  if (!lumpcache[lump])      // read the lump in
-    W_ReadLump(lump, Z_Malloc(W_LumpLength(lump), tag, &lumpcache[lump]));
-  else
-    Z_ChangeTag(lumpcache[lump],tag);
+  shared = lumpinfo[lump].cachelump;
+
+  if (!lumpcache[shared])      // read the lump in
+  {
+    W_ReadLump(shared, Z_Malloc(W_LumpLength(shared), tag, &lumpcache[shared]));
+
+    if (dedup_lumps && lumpcache[shared])
+    {
+      const int other = DedupLump(shared);
+      fresh = (other == shared);
+      shared = other;
+    }
+  }
 
-  return lumpcache[lump];
+  // [Woof!] shared blocks keep the strongest tag of their lumps
+  if (dedup_lumps && lumpcache[shared])
+    tag = SharedLumpTag(lump, shared, tag, fresh);
+
+  Z_ChangeTag(lumpcache[shared],tag);
+
+  return lumpcache[shared];
 }
 
 // W_CacheLumpName macroized in w_wad.h -- killough
@@ -649,6 +1019,17 @@ void W_Close(void)
     }
 }
 
+void W_Reopen(void)
+{
+    for (int i = 0; i < arrlen(modules); ++i)
+    {
+        if (modules[i]->Reopen)
+        {
+            modules[i]->Reopen();
+        }
+    }
+}
+
 //----------------------------------------------------------------------------
 //
 // $Log: w_wad.c,v $
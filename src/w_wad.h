@@ -77,7 +77,7 @@ typedef struct
     {
         archive_t *archive;
         const char *base_path;
-        FILE *descriptor;
+        int descriptor;
     } p1;
 
     union
@@ -109,6 +109,12 @@ typedef struct
 
   // [FG] WAD file that contains the lump
   const char *wad_file;
+
+  // [Woof!] lump whose lumpcache entry holds our data, see W_CacheLumpNum()
+  int cachelump;
+  // [Woof!] next lump sharing that entry or -1, and the tag we requested
+  int cachenext;
+  int cachetag;
 } lumpinfo_t;
 
 extern lumpinfo_t *lumpinfo;
@@ -163,6 +169,9 @@ int W_LumpLengthWithName(int lump, char *name);
 
 void W_Close(void);
 
+// [Woof!] Called in a child process after fork().
+void W_Reopen(void);
+
 #endif
 
 //----------------------------------------------------------------------------
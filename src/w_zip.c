@@ -33,6 +33,7 @@ struct archive_s
 {
     mz_zip_archive *zip;
     record_t *directory;
+    char *path;
 };
 
 static archive_t *archives;
@@ -228,7 +229,7 @@ static w_type_t W_ZIP_Open(const char *path, w_handle_t *handle)
 
     I_Printf(VB_INFO, " adding %s", path);
 
-    archive_t archive = {zip, directory};
+    archive_t archive = {zip, directory, M_StringDuplicate(path)};
     array_push(archives, archive);
     handle->p1.archive = array_end(archives) - 1;
 
@@ -254,10 +255,28 @@ static void W_ZIP_Close(void)
     }
 }
 
+// The archives are read through stdio streams, which share their file
+// position with forked processes.
+
+static void W_ZIP_Reopen(void)
+{
+    for (int i = 0; i < array_size(archives); ++i)
+    {
+        mz_zip_reader_end(archives[i].zip);
+
+        if (!mz_zip_reader_init_file(archives[i].zip, archives[i].path,
+                                     MZ_ZIP_FLAG_DO_NOT_SORT_CENTRAL_DIRECTORY))
+        {
+            I_Error("Failed to reopen %s", archives[i].path);
+        }
+    }
+}
+
 w_module_t w_zip_module =
 {
     W_ZIP_AddDir,
     W_ZIP_Open,
     W_ZIP_Read,
-    W_ZIP_Close
+    W_ZIP_Close,
+    W_ZIP_Reopen
 };